@@ -0,0 +1,151 @@
+#include "framegrabber.h"
+#include <QMutex>
+#include <QList>
+#include <QElapsedTimer>
+#include <cstring>
+
+namespace {
+    const int MAX_IDLE_HANDLES = 4;
+    const int LOAD_TIMEOUT_MS = 8000;
+    QMutex poolMutex;
+    QList<mpv_handle*> idleHandles;
+}
+
+QImage FrameGrabber::grab(const QString &path) {
+    mpv_handle *mpv = acquireHandle();
+    if(!mpv)
+        return QImage();
+    QImage frame;
+    QByteArray pathUtf8 = path.toUtf8();
+    const char *loadCmd[] = { "loadfile", pathUtf8.constData(), "replace", nullptr };
+    if(mpv_command(mpv, loadCmd) >= 0 && waitForFrame(mpv))
+        frame = copyFrame(mpv);
+    const char *stopCmd[] = { "stop", nullptr };
+    mpv_command(mpv, stopCmd);
+    releaseHandle(mpv);
+    return frame;
+}
+
+mpv_handle *FrameGrabber::acquireHandle() {
+    {
+        QMutexLocker locker(&poolMutex);
+        if(!idleHandles.isEmpty())
+            return idleHandles.takeLast();
+    }
+    return createHandle();
+}
+
+void FrameGrabber::releaseHandle(mpv_handle *mpv) {
+    QMutexLocker locker(&poolMutex);
+    if(idleHandles.count() < MAX_IDLE_HANDLES)
+        idleHandles.append(mpv);
+    else
+        mpv_terminate_destroy(mpv);
+}
+
+mpv_handle *FrameGrabber::createHandle() {
+    mpv_handle *mpv = mpv_create();
+    if(!mpv)
+        return nullptr;
+    mpv_set_option_string(mpv, "config", "no");
+    mpv_set_option_string(mpv, "load-scripts", "no");
+    mpv_set_option_string(mpv, "terminal", "no");
+    mpv_set_option_string(mpv, "ytdl", "no");
+    mpv_set_option_string(mpv, "idle", "yes");
+    mpv_set_option_string(mpv, "vo", "null");
+    mpv_set_option_string(mpv, "ao", "null");
+    mpv_set_option_string(mpv, "aid", "no");
+    mpv_set_option_string(mpv, "sid", "no");
+    mpv_set_option_string(mpv, "hwdec", "no");
+    // stop on the first frame after the initial seek
+    mpv_set_option_string(mpv, "pause", "yes");
+    mpv_set_option_string(mpv, "start", "30%");
+    // keyframe seek; that is good enough for a thumbnail
+    mpv_set_option_string(mpv, "hr-seek", "no");
+    if(mpv_initialize(mpv) < 0) {
+        mpv_terminate_destroy(mpv);
+        return nullptr;
+    }
+    return mpv;
+}
+
+// wait until the first frame after seek is out
+// events left from the previous file end before START_FILE, so they are ignored
+bool FrameGrabber::waitForFrame(mpv_handle *mpv) {
+    QElapsedTimer timer;
+    timer.start();
+    bool started = false, loaded = false;
+    qint64 remaining;
+    while((remaining = LOAD_TIMEOUT_MS - timer.elapsed()) > 0) {
+        mpv_event *event = mpv_wait_event(mpv, remaining / 1000.0);
+        switch(event->event_id) {
+        case MPV_EVENT_START_FILE:
+            started = true;
+            break;
+        case MPV_EVENT_FILE_LOADED:
+            loaded = started;
+            break;
+        case MPV_EVENT_PLAYBACK_RESTART:
+            if(loaded)
+                return true;
+            break;
+        case MPV_EVENT_END_FILE:
+            if(started)
+                return false;
+            break;
+        case MPV_EVENT_SHUTDOWN:
+            return false;
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
+QImage FrameGrabber::copyFrame(mpv_handle *mpv) {
+    const char *cmd[] = { "screenshot-raw", "video", nullptr };
+    mpv_node result;
+    if(mpv_command_ret(mpv, cmd, &result) < 0)
+        return QImage();
+    QImage frame;
+    if(result.format == MPV_FORMAT_NODE_MAP) {
+        int64_t w = 0, h = 0, stride = 0;
+        const char *format = "";
+        mpv_byte_array *data = nullptr;
+        mpv_node_list *map = result.u.list;
+        for(int i = 0; i < map->num; i++) {
+            const char *key = map->keys[i];
+            const mpv_node &value = map->values[i];
+            if(strcmp(key, "w") == 0 && value.format == MPV_FORMAT_INT64)
+                w = value.u.int64;
+            else if(strcmp(key, "h") == 0 && value.format == MPV_FORMAT_INT64)
+                h = value.u.int64;
+            else if(strcmp(key, "stride") == 0 && value.format == MPV_FORMAT_INT64)
+                stride = value.u.int64;
+            else if(strcmp(key, "format") == 0 && value.format == MPV_FORMAT_STRING)
+                format = value.u.string;
+            else if(strcmp(key, "data") == 0 && value.format == MPV_FORMAT_BYTE_ARRAY)
+                data = value.u.ba;
+        }
+        // bgr0 / bgra match Qt's 32 bit formats byte for byte (on little endian)
+        QImage::Format qFormat = QImage::Format_Invalid;
+        if(strcmp(format, "bgr0") == 0)
+            qFormat = QImage::Format_RGB32;
+        else if(strcmp(format, "bgra") == 0)
+            qFormat = QImage::Format_ARGB32;
+        if(qFormat != QImage::Format_Invalid && data && w > 0 && h > 0 && stride >= w * 4 &&
+           static_cast<int64_t>(data->size) >= stride * h)
+        {
+            // copy out; the buffer is freed along with the node
+            frame = QImage(static_cast<const uchar*>(data->data), static_cast<int>(w),
+                           static_cast<int>(h), static_cast<int>(stride), qFormat).copy();
+        }
+    }
+    mpv_free_node_contents(&result);
+    return frame;
+}
+
+bool GrabVideoFrame(const QString &path, QImage &frame) {
+    frame = FrameGrabber::grab(path);
+    return !frame.isNull();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// Headless frame extraction for thumbnails.
+// Keeps a small pool of mpv handles (no video output) around,
+// so there are no process launches or temporary files involved.
+
+#include <QImage>
+#include <QString>
+#include <mpv/client.h>
+
+#if defined QIMGV_PLAYER_MPV_LIBRARY
+ #define FRAMEGRABBER_DLLSPEC Q_DECL_EXPORT
+#else
+ #define FRAMEGRABBER_DLLSPEC Q_DECL_IMPORT
+#endif
+
+class FrameGrabber {
+public:
+    // seeks to the keyframe nearest to 30% and returns that frame
+    // thread safe; returns a null image on failure
+    static QImage grab(const QString &path);
+
+private:
+    static mpv_handle *acquireHandle();
+    static void releaseHandle(mpv_handle *mpv);
+    static mpv_handle *createHandle();
+    static bool waitForFrame(mpv_handle *mpv);
+    static QImage copyFrame(mpv_handle *mpv);
+};
+
+extern "C" FRAMEGRABBER_DLLSPEC bool GrabVideoFrame(const QString &path, QImage &frame);
@@ -71,6 +71,7 @@ void ActionManager::initDefaults() {
     actionManager->defaults.insert(".", "frameStep");
     actionManager->defaults.insert("Enter", "folderView");
     actionManager->defaults.insert("Backspace", "folderView");
+    actionManager->defaults.insert("/", "filterFolderView");
     actionManager->defaults.insert("F5", "reloadImage");
     actionManager->defaults.insert(InputMap::keyNameCtrl() + "+C", "copyFileClipboard");
     actionManager->defaults.insert(InputMap::keyNameCtrl() + "+" + InputMap::keyNameShift() + "+C", "copyPathClipboard");
@@ -106,6 +106,9 @@ signals:
     void sortByName();
     void sortByTime();
     void sortBySize();
+    void sortByDateTaken();
+    void sortByDimensions();
+    void filterFolderView();
     void toggleImageInfo();
     void toggleShuffle();
     void toggleScalingFilter();
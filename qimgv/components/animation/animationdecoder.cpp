@@ -0,0 +1,172 @@
+#include "animationdecoder.h"
+
+#define TAG "[AnimationDecoder]"
+// browsers treat tiny delays as "unset"
+#define MIN_FRAME_DELAY 11
+#define DEFAULT_FRAME_DELAY 100
+
+AnimationDecoder::AnimationDecoder(const QString &path, const QByteArray &format)
+    : mPath(path),
+      mFormat(format),
+      readerPos(-1),
+      mFrameCount(0),
+      mFrameCountKnown(false),
+      maxCached(2),
+      anchor(0)
+{
+    restart();
+    int count = reader->imageCount();
+    if(count > 0) {
+        mFrameCount = count;
+        mFrameCountKnown = true;
+        frames.resize(count);
+        delays.resize(count, -1);
+    }
+    // first frame tells the real size and gives the viewer something to show
+    if(!readNext()) {
+        qDebug() << TAG << mPath << reader->errorString();
+        return;
+    }
+    mSize = lastRead.size();
+    qint64 frameBytes = qMax(static_cast<qint64>(lastRead.sizeInBytes()), qint64(1));
+    maxCached = static_cast<int>(qBound(qint64(2), ANIMATION_CACHE_BUDGET / frameBytes, qint64(INT_MAX)));
+}
+
+void AnimationDecoder::restart() {
+    reader.reset(new QImageReader(mPath, mFormat));
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    reader->setAllocationLimit(settings->memoryAllocationLimit());
+#endif
+    readerPos = -1;
+}
+
+bool AnimationDecoder::isValid() const {
+    return !mSize.isEmpty();
+}
+
+int AnimationDecoder::frameCount() const {
+    QMutexLocker locker(&cacheMutex);
+    return mFrameCount;
+}
+
+bool AnimationDecoder::frameCountKnown() const {
+    QMutexLocker locker(&cacheMutex);
+    return mFrameCountKnown;
+}
+
+QSize AnimationDecoder::size() const {
+    return mSize;
+}
+
+int AnimationDecoder::frameDelay(int index) const {
+    QMutexLocker locker(&cacheMutex);
+    if(index < 0 || index >= static_cast<int>(delays.size()))
+        return -1;
+    return delays[index];
+}
+
+bool AnimationDecoder::isCached(int index) const {
+    QMutexLocker locker(&cacheMutex);
+    return index >= 0 && index < static_cast<int>(frames.size()) && !frames[index].isNull();
+}
+
+bool AnimationDecoder::isFullyCached() const {
+    QMutexLocker locker(&cacheMutex);
+    return mFrameCountKnown && static_cast<int>(cached.size()) == mFrameCount;
+}
+
+bool AnimationDecoder::cachedFrame(int index, QImage &image) const {
+    QMutexLocker locker(&cacheMutex);
+    if(index < 0 || index >= static_cast<int>(frames.size()) || frames[index].isNull())
+        return false;
+    image = frames[index];
+    return true;
+}
+
+QImage AnimationDecoder::frame(int index) {
+    {
+        QMutexLocker locker(&cacheMutex);
+        if(index < 0 || (mFrameCountKnown && index >= mFrameCount))
+            return QImage();
+    }
+    QMutexLocker locker(&decodeMutex);
+    anchor = index;
+    QImage image;
+    if(cachedFrame(index, image))
+        return image;
+    if(index == readerPos)
+        return lastRead;
+    if(index < readerPos)
+        restart();
+    while(readerPos < index) {
+        if(!readNext())
+            return QImage();
+    }
+    return lastRead;
+}
+
+bool AnimationDecoder::readNext() {
+    QImage image = reader->read();
+    QMutexLocker locker(&cacheMutex);
+    if(image.isNull()) {
+        // ran out early, or the count was never known
+        if(readerPos >= 0 && (!mFrameCountKnown || readerPos + 1 < mFrameCount)) {
+            mFrameCount = readerPos + 1;
+            mFrameCountKnown = true;
+            frames.resize(mFrameCount);
+            delays.resize(mFrameCount);
+            cached.erase(std::remove_if(cached.begin(), cached.end(),
+                                        [this](int i) { return i >= mFrameCount; }), cached.end());
+        }
+        return false;
+    }
+    readerPos++;
+    if(readerPos >= static_cast<int>(frames.size())) {
+        frames.resize(readerPos + 1);
+        delays.resize(readerPos + 1, -1);
+        mFrameCount = readerPos + 1;
+    }
+    int delay = reader->nextImageDelay();
+    delays[readerPos] = (delay < MIN_FRAME_DELAY) ? DEFAULT_FRAME_DELAY : delay;
+    lastRead = image;
+    if(frames[readerPos].isNull() && keep(readerPos))
+        store(readerPos, image);
+    return true;
+}
+
+// playback runs forward, so frames ahead of the anchor are worth more
+int AnimationDecoder::distance(int index) const {
+    int ahead = index - anchor;
+    int behind = anchor - index;
+    if(mFrameCountKnown) {
+        ahead = (ahead + mFrameCount) % mFrameCount;
+        behind = (behind + mFrameCount) % mFrameCount;
+    } else if(ahead < 0) {
+        ahead = INT_MAX / 4;
+    } else {
+        behind = INT_MAX / 4;
+    }
+    return qMin(ahead, behind * 3);
+}
+
+bool AnimationDecoder::keep(int index) const {
+    if(static_cast<int>(cached.size()) < maxCached)
+        return true;
+    int farthest = 0;
+    for(auto i : cached)
+        farthest = qMax(farthest, distance(i));
+    return distance(index) < farthest;
+}
+
+void AnimationDecoder::store(int index, const QImage &image) {
+    if(static_cast<int>(cached.size()) >= maxCached) {
+        auto victim = std::max_element(cached.begin(), cached.end(), [this](int a, int b) {
+            return distance(a) < distance(b);
+        });
+        frames[*victim] = QImage();
+        *victim = index;
+    } else {
+        cached.push_back(index);
+    }
+    frames[index] = image;
+}
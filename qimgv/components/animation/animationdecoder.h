@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QImageReader>
+#include <QImage>
+#include <QString>
+#include <QDebug>
+#include <QMutex>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include "settings.h"
+
+// decoded frames kept per animation, in bytes
+#define ANIMATION_CACHE_BUDGET (192 * 1024 * 1024)
+
+// Random access to the frames of an animated image.
+//
+// Image readers only go forward, and a frame may be drawn over the previous
+// ones (gif / apng disposal). So every frame is stored the way the reader
+// returns it: composited onto the full canvas. A stored frame never needs its
+// neighbours, and showing it again costs nothing.
+//
+// Animations that fit ANIMATION_CACHE_BUDGET are kept whole after the first pass.
+// Longer ones keep a window around the last requested frame, biased forward;
+// stepping back past it re-reads from the start and refills the window on the way.
+//
+// Thread safe. Decoding is serialized; cached frames and the frame info
+// can be read while another thread decodes.
+class AnimationDecoder {
+public:
+    AnimationDecoder(const QString &path, const QByteArray &format);
+
+    bool isValid() const;
+    // exact once the first pass is done; formats without a frame count
+    // report the frames read so far until then
+    int frameCount() const;
+    bool frameCountKnown() const;
+    QSize size() const;
+    // ms until the next frame; -1 if not decoded yet
+    int frameDelay(int index) const;
+    // null on failure or past the last frame
+    QImage frame(int index);
+    // never decodes
+    bool cachedFrame(int index, QImage &image) const;
+    bool isCached(int index) const;
+    bool isFullyCached() const;
+
+private:
+    bool readNext();
+    void restart();
+    void store(int index, const QImage &image);
+    bool keep(int index) const;
+    int distance(int index) const;
+
+    QString mPath;
+    QByteArray mFormat;
+    // held while decoding; the reader state below belongs to it
+    QMutex decodeMutex;
+    std::unique_ptr<QImageReader> reader;
+    // last frame taken from the reader
+    int readerPos;
+    QImage lastRead;
+    QSize mSize;
+    // guards the cache columns and the frame count
+    mutable QMutex cacheMutex;
+    std::vector<QImage> frames;
+    std::vector<int> delays;
+    std::vector<int> cached;
+    int mFrameCount;
+    bool mFrameCountKnown;
+    int maxCached;
+    // last requested frame; the window is centered on it
+    int anchor;
+};
@@ -0,0 +1,172 @@
+#include "animationprefetcher.h"
+#include "utils/imagelib.h"
+
+#define TAG "[AnimationPrefetcher]"
+
+AnimationPrefetcher::AnimationPrefetcher(std::shared_ptr<AnimationDecoder> _decoder, QObject *parent)
+    : QObject(parent),
+      decoder(_decoder),
+      nextToDecode(0),
+      generation(0),
+      stopped(false),
+      running(true),
+      discarded(false),
+      targetFilter(QI_FILTER_BILINEAR)
+{
+    pool.setMaxThreadCount(1);
+    pool.start([this]() {
+        run();
+        onWorkerDone();
+    });
+}
+
+AnimationPrefetcher::~AnimationPrefetcher() {
+    {
+        QMutexLocker locker(&mutex);
+        stopped = true;
+        wake.wakeAll();
+    }
+    pool.waitForDone();
+}
+
+void AnimationPrefetcher::discard() {
+    disconnect();
+    bool idle;
+    {
+        QMutexLocker locker(&mutex);
+        stopped = true;
+        discarded = true;
+        idle = !running;
+        wake.wakeAll();
+    }
+    // otherwise the worker schedules it on the way out
+    if(idle)
+        deleteLater();
+}
+
+// worker thread, last thing it does
+void AnimationPrefetcher::onWorkerDone() {
+    QMutexLocker locker(&mutex);
+    running = false;
+    if(discarded)
+        QMetaObject::invokeMethod(this, "deleteLater", Qt::QueuedConnection);
+}
+
+void AnimationPrefetcher::seek(int frame) {
+    QMutexLocker locker(&mutex);
+    ring.clear();
+    nextToDecode = frame;
+    generation++;
+    wake.wakeAll();
+}
+
+int AnimationPrefetcher::nextIndex() {
+    QMutexLocker locker(&mutex);
+    return ring.empty() ? -1 : ring.front().index;
+}
+
+bool AnimationPrefetcher::take(AnimationFrame &frame) {
+    QMutexLocker locker(&mutex);
+    if(ring.empty())
+        return false;
+    frame = ring.front();
+    ring.pop_front();
+    wake.wakeAll();
+    return true;
+}
+
+void AnimationPrefetcher::setScaling(QSize size, ScalingFilter filter) {
+    QMutexLocker locker(&mutex);
+    if(size == targetSize && (size.isEmpty() || filter == targetFilter))
+        return;
+    targetSize = size;
+    targetFilter = filter;
+    if(!ring.empty()) {
+        nextToDecode = ring.front().index;
+        ring.clear();
+    }
+    generation++;
+    wake.wakeAll();
+}
+
+// worker thread
+void AnimationPrefetcher::run() {
+    int failedGeneration = -1;
+    while(true) {
+        int index, frameGeneration;
+        QSize size;
+        ScalingFilter filter;
+        {
+            QMutexLocker locker(&mutex);
+            while(!stopped && (ring.size() >= ANIMATION_PREFETCH || generation == failedGeneration))
+                wake.wait(&mutex);
+            if(stopped)
+                return;
+            index = nextToDecode;
+            frameGeneration = generation;
+            size = targetSize;
+            filter = targetFilter;
+        }
+        int count = decoder->frameCount();
+        if(decoder->frameCountKnown() && index >= count)
+            index = 0;
+        AnimationFrame frame;
+        frame.index = index;
+        frame.image = decoder->frame(index);
+        frame.delay = decoder->frameDelay(index);
+        bool end = frame.image.isNull();
+        if(end && (index == 0 || !decoder->frameCountKnown())) {
+            // broken file; sleep until the next seek
+            qDebug() << TAG << "could not decode frame" << index;
+            failedGeneration = frameGeneration;
+            emit failed();
+            continue;
+        }
+        if(decoder->frameCount() != count)
+            emit frameCountChanged(decoder->frameCount());
+        if(!end && !size.isEmpty())
+            frame.scaled = scaledFrame(index, frame.image, size, filter);
+        bool wasEmpty;
+        {
+            QMutexLocker locker(&mutex);
+            if(frameGeneration != generation)
+                continue;
+            if(end) {
+                // past the last frame; wrap around
+                nextToDecode = 0;
+                continue;
+            }
+            wasEmpty = ring.empty();
+            ring.push_back(frame);
+            nextToDecode = index + 1;
+        }
+        if(wasEmpty)
+            emit frameReady();
+    }
+}
+
+QImage AnimationPrefetcher::scaledFrame(int index, const QImage &image, QSize size, ScalingFilter filter) {
+    auto level = std::find_if(scaledLevels.begin(), scaledLevels.end(), [&](const ScaledLevel &l) {
+        return l.size == size && l.filter == filter;
+    });
+    if(level == scaledLevels.end()) {
+        scaledLevels.push_front(ScaledLevel{ size, filter });
+        if(scaledLevels.size() > ANIMATION_SCALED_LEVELS)
+            scaledLevels.pop_back();
+    } else if(level != scaledLevels.begin()) {
+        std::rotate(scaledLevels.begin(), level, level + 1);
+    }
+    ScaledLevel &current = scaledLevels.front();
+    auto cached = current.frames.constFind(index);
+    if(cached != current.frames.constEnd())
+        return *cached;
+    std::unique_ptr<QImage> scaled(ImageLib::scaled(std::make_shared<const QImage>(image), size, filter));
+    if(!scaled)
+        return QImage();
+    // past the budget frames are still scaled, just not kept
+    if(current.bytes + scaled->sizeInBytes() <= ANIMATION_SCALED_BUDGET) {
+        current.frames.insert(index, *scaled);
+        current.bytes += scaled->sizeInBytes();
+    }
+    return *scaled;
+}
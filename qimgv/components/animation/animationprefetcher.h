@@ -0,0 +1,87 @@
+#pragma once
+
+#include <QObject>
+#include <QThreadPool>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <deque>
+#include <memory>
+#include "animationdecoder.h"
+
+// frames decoded ahead of the one on screen
+#define ANIMATION_PREFETCH 6
+// zoom levels with resampled frames kept
+#define ANIMATION_SCALED_LEVELS 2
+// resampled frames kept per zoom level, in bytes
+#define ANIMATION_SCALED_BUDGET (64 * 1024 * 1024)
+
+struct AnimationFrame {
+    int index = -1;
+    QImage image;
+    // resampled for the view; null when scaling is off
+    QImage scaled;
+    // ms to show it for
+    int delay = 0;
+};
+
+// Decodes an animation on a worker thread, a few frames ahead of playback.
+// Frames come out in playback order, wrapping around at the end.
+// The GUI thread only takes finished frames from the ring.
+// With a target size set, frames are also resampled here with the configured
+// filter, and the results are kept per zoom level.
+class AnimationPrefetcher : public QObject {
+    Q_OBJECT
+public:
+    explicit AnimationPrefetcher(std::shared_ptr<AnimationDecoder> _decoder, QObject *parent = nullptr);
+    // waits for the worker; use discard() on the GUI thread
+    ~AnimationPrefetcher();
+
+    // stops the worker without waiting for the frame in progress,
+    // and deletes this once it is out. Signals are disconnected
+    void discard();
+
+    // drops the ring and continues from `frame`
+    void seek(int frame);
+    // index of the frame take() would return; -1 while the ring is empty
+    int nextIndex();
+    bool take(AnimationFrame &frame);
+    // device pixels; an empty size turns scaling off.
+    // Frames already in the ring are redone
+    void setScaling(QSize size, ScalingFilter filter);
+
+signals:
+    // the ring got its first frame
+    void frameReady();
+    // the count grew or settled; only for formats that don't report it upfront
+    void frameCountChanged(int count);
+    void failed();
+
+private:
+    struct ScaledLevel {
+        QSize size;
+        ScalingFilter filter;
+        QHash<int, QImage> frames;
+        qint64 bytes = 0;
+    };
+
+    void run();
+    void onWorkerDone();
+    // worker thread only
+    QImage scaledFrame(int index, const QImage &image, QSize size, ScalingFilter filter);
+    std::shared_ptr<AnimationDecoder> decoder;
+    QThreadPool pool;
+    QMutex mutex;
+    QWaitCondition wake;
+    std::deque<AnimationFrame> ring;
+    int nextToDecode;
+    // bumped on seek; frames decoded for an older one are dropped
+    int generation;
+    bool stopped;
+    bool running;
+    bool discarded;
+    QSize targetSize;
+    ScalingFilter targetFilter;
+    // most recently used first
+    std::deque<ScaledLevel> scaledLevels;
+};
@@ -0,0 +1,281 @@
+#include "metadataindex.h"
+
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QImageReader>
+#include <QDebug>
+
+#ifdef USE_EXIV2
+#include <exiv2/exiv2.hpp>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <sys/stat.h>
+#endif
+
+#define TAG "[MetadataIndex]"
+#define METADATA_INDEX_MAGIC   0x514D4458 // "QMDX"
+#define METADATA_INDEX_VERSION 2
+
+MetadataIndex *metadataIndex = nullptr;
+
+MetadataIndex::MetadataIndex(QObject *parent) : QObject(parent) {
+    // header reads are cheap; one thread leaves the disk to the loader and thumbnailer.
+    // Also keeps load() ahead of every indexing task
+    pool.setMaxThreadCount(1);
+    pending++;
+    pool.start([this]() {
+        load();
+        if(--pending == 0 && updated.exchange(false))
+            emit indexUpdated();
+    });
+}
+
+MetadataIndex::~MetadataIndex() {
+    pool.clear();
+    pool.waitForDone();
+    QMutexLocker locker(&logMutex);
+    log.close();
+}
+
+MetadataIndex *MetadataIndex::getInstance() {
+    if(!metadataIndex)
+        metadataIndex = new MetadataIndex();
+    return metadataIndex;
+}
+
+QString MetadataIndex::logPath() const {
+    return settings->tmpDir() + "metadata.idx";
+}
+
+// inode numbers are only unique within one filesystem, hence the device
+MetadataKey MetadataIndex::fileKey(quint64 device, quint64 inode, const QString &path, qint64 mtime) {
+    if(inode)
+        return MetadataKey{ device, inode, mtime };
+    // no inodes here; top bit keeps path ids apart from inode numbers
+    quint64 id = (static_cast<quint64>(qHash(path, 0x9e3779b9)) << 32) | qHash(path);
+    return MetadataKey{ 0, id | (Q_UINT64_C(1) << 63), mtime };
+}
+
+bool MetadataIndex::keyForPath(const QString &path, MetadataKey &key) {
+#ifdef Q_OS_LINUX
+    struct stat st;
+    if(::stat(QFile::encodeName(path).constData(), &st) != 0)
+        return false;
+    qint64 mtime = static_cast<qint64>(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+    key = fileKey(st.st_dev, st.st_ino, path, mtime);
+#else
+    QFileInfo info(path);
+    if(!info.exists())
+        return false;
+    key = fileKey(0, 0, info.absoluteFilePath(), info.lastModified().toMSecsSinceEpoch());
+#endif
+    return true;
+}
+
+std::shared_ptr<const ImageMetadata> MetadataIndex::lookup(const MetadataKey &key) const {
+    QReadLocker locker(&lock);
+    return entries.value(key);
+}
+
+void MetadataIndex::request(const QList<MetadataRequest> &requests) {
+    QMutexLocker locker(&queueMutex);
+    for(auto &request : requests) {
+        if(queued.contains(request.key))
+            continue;
+        queued.insert(request.key);
+        pending++;
+        pool.start([this, request]() {
+            indexFile(request);
+        });
+    }
+}
+
+// worker thread
+void MetadataIndex::indexFile(const MetadataRequest &request) {
+    if(!lookup(request.key)) {
+        ImageMetadata metadata = extract(request.path);
+        if(insert(request.key, metadata)) {
+            writeRecord(request.key, metadata);
+            updated = true;
+        }
+    }
+    {
+        QMutexLocker locker(&queueMutex);
+        queued.remove(request.key);
+    }
+    if(--pending == 0) {
+        {
+            QMutexLocker locker(&logMutex);
+            log.flush();
+        }
+        if(updated.exchange(false))
+            emit indexUpdated();
+    }
+}
+
+void MetadataIndex::ensure(const QString &path) {
+    MetadataKey key;
+    if(!keyForPath(path, key) || lookup(key))
+        return;
+    ImageMetadata metadata = extract(path);
+    if(insert(key, metadata)) {
+        writeRecord(key, metadata);
+        QMutexLocker locker(&logMutex);
+        log.flush();
+    }
+}
+
+void MetadataIndex::setIndexOnRead(bool mode) {
+    mIndexOnRead = mode;
+}
+
+bool MetadataIndex::indexOnRead() const {
+    return mIndexOnRead;
+}
+
+void MetadataIndex::store(const QString &path, const ImageMetadata &metadata) {
+    MetadataKey key;
+    if(!keyForPath(path, key) || lookup(key))
+        return;
+    if(insert(key, metadata)) {
+        writeRecord(key, metadata);
+        QMutexLocker locker(&logMutex);
+        log.flush();
+    }
+}
+
+bool MetadataIndex::insert(const MetadataKey &key, const ImageMetadata &metadata) {
+    QWriteLocker locker(&lock);
+    if(entries.contains(key))
+        return false;
+    // older versions of the same file are dead weight
+    QPair<quint64, quint64> file(key.device, key.file);
+    auto version = versions.find(file);
+    if(version != versions.end()) {
+        if(version.value() > key.mtime)
+            return false;
+        entries.remove(MetadataKey{ key.device, key.file, version.value() });
+    }
+    versions.insert(file, key.mtime);
+    entries.insert(key, std::make_shared<const ImageMetadata>(metadata));
+    return true;
+}
+
+static void writeEntry(QDataStream &out, const MetadataKey &key, const ImageMetadata &metadata) {
+    out << key.device << key.file << key.mtime << metadata.dateTaken << metadata.camera
+        << qint32(metadata.size.width()) << qint32(metadata.size.height());
+}
+
+// thread safe
+void MetadataIndex::writeRecord(const MetadataKey &key, const ImageMetadata &metadata) {
+    QMutexLocker locker(&logMutex);
+    if(!log.isOpen())
+        return;
+    QDataStream out(&log);
+    out.setVersion(QDataStream::Qt_5_15);
+    writeEntry(out, key, metadata);
+}
+
+// Reads the log, then rewrites it if it had stale versions or a broken tail.
+// Leaves the log open for appending
+void MetadataIndex::load() {
+    QFile file(logPath());
+    int records = 0;
+    bool valid = false, truncated = false;
+    if(file.open(QIODevice::ReadOnly)) {
+        QDataStream in(&file);
+        in.setVersion(QDataStream::Qt_5_15);
+        quint32 magic, version;
+        in >> magic >> version;
+        valid = (in.status() == QDataStream::Ok && magic == METADATA_INDEX_MAGIC && version == METADATA_INDEX_VERSION);
+        while(valid && !in.atEnd()) {
+            MetadataKey key;
+            ImageMetadata metadata;
+            qint32 width, height;
+            in >> key.device >> key.file >> key.mtime >> metadata.dateTaken >> metadata.camera >> width >> height;
+            if(in.status() != QDataStream::Ok) {
+                qDebug() << TAG << "truncated index, dropping the tail";
+                truncated = true;
+                break;
+            }
+            metadata.size = QSize(width, height);
+            insert(key, metadata);
+            records++;
+        }
+        file.close();
+    }
+    QMutexLocker locker(&logMutex);
+    // appending after a broken tail would lose everything written from now on
+    if(!valid || truncated || records != entries.count()) {
+        QSaveFile compacted(logPath());
+        if(compacted.open(QIODevice::WriteOnly)) {
+            QDataStream out(&compacted);
+            out.setVersion(QDataStream::Qt_5_15);
+            out << quint32(METADATA_INDEX_MAGIC) << quint32(METADATA_INDEX_VERSION);
+            QReadLocker readLocker(&lock);
+            for(auto it = entries.constBegin(); it != entries.constEnd(); ++it)
+                writeEntry(out, it.key(), *it.value());
+            compacted.commit();
+        }
+    }
+    log.setFileName(logPath());
+    if(!log.open(QIODevice::WriteOnly | QIODevice::Append))
+        qDebug() << TAG << "could not open" << logPath();
+    if(!entries.isEmpty())
+        updated = true;
+}
+
+ImageMetadata MetadataIndex::extract(const QString &path) {
+    ImageMetadata metadata;
+#ifdef USE_EXIV2
+    try {
+        auto image = Exiv2::ImageFactory::open(path.toStdString());
+        if(image.get()) {
+            image->readMetadata();
+            metadata = fromExif(*image);
+        }
+    } catch(std::exception &e) {
+        qDebug() << TAG << path << e.what();
+    }
+#endif
+    if(metadata.size.isEmpty())
+        metadata.size = QImageReader(path).size();
+    return metadata;
+}
+
+#ifdef USE_EXIV2
+ImageMetadata MetadataIndex::fromExif(Exiv2::Image &image) {
+    ImageMetadata metadata;
+    metadata.size = QSize(image.pixelWidth(), image.pixelHeight());
+    Exiv2::ExifData &exifData = image.exifData();
+    if(exifData.empty())
+        return metadata;
+
+    auto it = exifData.findKey(Exiv2::ExifKey("Exif.Photo.DateTimeOriginal"));
+    if(it == exifData.end())
+        it = exifData.findKey(Exiv2::ExifKey("Exif.Image.DateTime"));
+    if(it != exifData.end()) {
+        QString dateString = QString::fromStdString(it->value().toString()).trimmed();
+        QDateTime date = QDateTime::fromString(dateString, "yyyy:MM:dd HH:mm:ss");
+        if(date.isValid())
+            metadata.dateTaken = date.toMSecsSinceEpoch();
+    }
+
+    QString make, model;
+    it = exifData.findKey(Exiv2::ExifKey("Exif.Image.Make"));
+    if(it != exifData.end())
+        make = QString::fromStdString(it->value().toString()).trimmed();
+    it = exifData.findKey(Exiv2::ExifKey("Exif.Image.Model"));
+    if(it != exifData.end())
+        model = QString::fromStdString(it->value().toString()).trimmed();
+    // most vendors repeat the make in the model name
+    if(make.isEmpty() || model.startsWith(make, Qt::CaseInsensitive))
+        metadata.camera = model;
+    else
+        metadata.camera = (make + " " + model).trimmed();
+    return metadata;
+}
+#endif
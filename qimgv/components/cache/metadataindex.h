@@ -0,0 +1,110 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QSize>
+#include <QFile>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+#include "settings.h"
+
+#ifdef USE_EXIV2
+namespace Exiv2 {
+    class Image;
+}
+#endif
+
+// one version of a file: survives renames and moves within a filesystem, not edits
+struct MetadataKey {
+    // st_dev; 0 with path ids
+    quint64 device;
+    // inode, or a hash of the path where there is none
+    quint64 file;
+    // msecs since epoch
+    qint64 mtime;
+};
+
+inline bool operator==(const MetadataKey &k1, const MetadataKey &k2) {
+    return k1.file == k2.file && k1.device == k2.device && k1.mtime == k2.mtime;
+}
+
+inline uint qHash(const MetadataKey &key, uint seed = 0) {
+    return qHash(key.file, seed) ^ qHash(key.device, seed) ^ qHash(key.mtime, seed);
+}
+
+struct ImageMetadata {
+    // DateTimeOriginal (or DateTime), msecs since epoch; -1 if unknown
+    qint64 dateTaken = -1;
+    // "Make Model"
+    QString camera;
+    // pixel dimensions as stored, orientation not applied
+    QSize size;
+};
+
+struct MetadataRequest {
+    QString path;
+    MetadataKey key;
+};
+
+// Image metadata used for sorting, extracted once per file version.
+// Files are indexed in the background and the results are appended to a log
+// next to the thumbnail cache, which is compacted on startup. Lookups never
+// touch the image files. Thread safe.
+class MetadataIndex : public QObject {
+    Q_OBJECT
+public:
+    static MetadataIndex* getInstance();
+    ~MetadataIndex();
+
+    static MetadataKey fileKey(quint64 device, quint64 inode, const QString &path, qint64 mtime);
+    // nullptr if not indexed (yet)
+    std::shared_ptr<const ImageMetadata> lookup(const MetadataKey &key) const;
+    // queues files for background indexing; known and already queued ones are skipped
+    void request(const QList<MetadataRequest> &requests);
+    // indexes right away, for callers that read the file anyway
+    void ensure(const QString &path);
+    // whether such callers should bother; on while a metadata sort is shown
+    void setIndexOnRead(bool mode);
+    bool indexOnRead() const;
+    void store(const QString &path, const ImageMetadata &metadata);
+
+    static ImageMetadata extract(const QString &path);
+#ifdef USE_EXIV2
+    static ImageMetadata fromExif(Exiv2::Image &image);
+#endif
+
+signals:
+    // new entries are available; emitted when the queue runs empty
+    void indexUpdated();
+
+private:
+    explicit MetadataIndex(QObject *parent = nullptr);
+    static bool keyForPath(const QString &path, MetadataKey &key);
+    void load();
+    void indexFile(const MetadataRequest &request);
+    // returns false if the key is already indexed
+    bool insert(const MetadataKey &key, const ImageMetadata &metadata);
+    void writeRecord(const MetadataKey &key, const ImageMetadata &metadata);
+    QString logPath() const;
+
+    mutable QReadWriteLock lock;
+    QHash<MetadataKey, std::shared_ptr<const ImageMetadata>> entries;
+    // latest indexed version of each file, by (device, file)
+    QHash<QPair<quint64, quint64>, qint64> versions;
+
+    QMutex logMutex;
+    QFile log;
+
+    QMutex queueMutex;
+    QSet<MetadataKey> queued;
+    QThreadPool pool;
+    std::atomic<int> pending{0};
+    std::atomic<bool> updated{false};
+    std::atomic<bool> mIndexOnRead{false};
+};
+
+extern MetadataIndex *metadataIndex;
@@ -1,7 +1,16 @@
 #include "thumbnailcache.h"
 
+ThumbnailCache *thumbnailCache = nullptr;
+
 ThumbnailCache::ThumbnailCache() {
     cacheDirPath = settings->thumbnailCacheDir();
+    masters.setMaxCost(96 * 1024);
+}
+
+ThumbnailCache *ThumbnailCache::getInstance() {
+    if(!thumbnailCache)
+        thumbnailCache = new ThumbnailCache();
+    return thumbnailCache;
 }
 
 QString ThumbnailCache::thumbnailPath(QString id) {
@@ -14,10 +23,18 @@ bool ThumbnailCache::exists(QString id) {
     return file.exists() && file.isReadable();
 }
 
+// stat-only check; does not verify the stored lastModified tag
+bool ThumbnailCache::isUpToDate(QString id, const QDateTime &sourceModified) {
+    QFileInfo file(thumbnailPath(id));
+    return file.exists() && file.lastModified() >= sourceModified;
+}
+
+// written via a temporary file so an interrupted write never leaves a broken thumbnail
 void ThumbnailCache::saveThumbnail(QImage *image, QString id) {
     if(image) {
-        QString filePath = thumbnailPath(id);
-        image->save(filePath, "PNG", 15);
+        QSaveFile file(thumbnailPath(id));
+        if(file.open(QIODevice::WriteOnly) && image->save(&file, "PNG", 15))
+            file.commit();
     }
 }
 
@@ -36,3 +53,19 @@ QImage *ThumbnailCache::readThumbnail(QString id) {
         return nullptr;
     }
 }
+
+QImage *ThumbnailCache::readMasterThumbnail(QString id) {
+    QMutexLocker locker(&mutex);
+    QImage *master = masters.object(id);
+    return master ? new QImage(*master) : nullptr;
+}
+
+bool ThumbnailCache::containsMasterThumbnail(QString id) {
+    QMutexLocker locker(&mutex);
+    return masters.contains(id);
+}
+
+void ThumbnailCache::storeMasterThumbnail(QString id, const QImage &image) {
+    QMutexLocker locker(&mutex);
+    masters.insert(id, new QImage(image), qMax(1, static_cast<int>(image.sizeInBytes() / 1024)));
+}
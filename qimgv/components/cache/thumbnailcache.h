@@ -2,7 +2,10 @@
 
 #include <QObject>
 #include <QDir>
+#include <QSaveFile>
+#include <QDateTime>
 #include <QMutex>
+#include <QCache>
 #include <QDebug>
 #include "settings.h"
 #include "sourcecontainers/thumbnail.h"
@@ -11,19 +14,30 @@ class ThumbnailCache : public QObject
 {
     Q_OBJECT
 public:
-    explicit ThumbnailCache();
+    // one instance shared by all thumbnailers, so they share master thumbnails
+    static ThumbnailCache* getInstance();
 
     void saveThumbnail(QImage *image, QString id);
     QImage* readThumbnail(QString id);
     QString thumbnailPath(QString id);
     bool exists(QString id);
+    bool isUpToDate(QString id, const QDateTime &sourceModified);
+    // in-memory master thumbnails (thread safe)
+    QImage* readMasterThumbnail(QString id);
+    bool containsMasterThumbnail(QString id);
+    void storeMasterThumbnail(QString id, const QImage &image);
 
 signals:
 
 public slots:
 
 private:
+    explicit ThumbnailCache();
     // we are still bottlenecked by disk access anyway
     QMutex mutex;
     QString cacheDirPath;
+    // cost is in KiB
+    QCache<QString, QImage> masters;
 };
+
+extern ThumbnailCache *thumbnailCache;
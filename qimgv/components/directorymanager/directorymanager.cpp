@@ -1,53 +1,145 @@
-#include <QDirIterator>
 #include "directorymanager.h"
 
 namespace fs = std::filesystem;
 
 DirectoryManager::DirectoryManager()
 {
-	m_collator.setNumericMode(true);
-
     readSettings();
     setSortingMode(settings->sortingMode());
     connect(settings, &Settings::settingsChanged, this, &DirectoryManager::readSettings);
-}
-
-template< typename T, typename Pred >
-typename QList<T>::iterator
-insert_sorted(QList<T> & vec, T const& item, Pred pred) {
-    return vec.insert(std::upper_bound(vec.begin(), vec.end(), item, pred), item);
-}
-
-bool DirectoryManager::path_entry_compare(const QFileInfo &e1, const QFileInfo &e2) const {
-    return m_collator.compare(e1.absoluteFilePath(), e2.absoluteFilePath()) < 0;
+    connect(&m_scanner, &DirectoryScanner::batchReady, this, &DirectoryManager::onScanBatch);
+    connect(&m_scanner, &DirectoryScanner::finished, this, &DirectoryManager::onScanFinished);
+    m_merge_timer.setSingleShot(true);
+    connect(&m_merge_timer, &QTimer::timeout, this, &DirectoryManager::mergeScanBatches);
+    m_external_timer.setSingleShot(true);
+    connect(&m_external_timer, &QTimer::timeout, this, &DirectoryManager::flushExternalEvents);
+    if(metadataIndex)
+        connect(metadataIndex, &MetadataIndex::indexUpdated, this, &DirectoryManager::onMetadataIndexUpdated);
+}
+
+// name comparisons use the collation keys precomputed by EntryStore
+bool DirectoryManager::path_entry_compare(const EntryStore &entries, int i1, int i2) const {
+    return entries.comparePaths(i1, i2) < 0;
 };
 
-bool DirectoryManager::path_entry_compare_reverse(const QFileInfo &e1, const QFileInfo &e2) const {
-    return m_collator.compare(e1.absoluteFilePath(), e2.absoluteFilePath()) > 0;
+bool DirectoryManager::path_entry_compare_reverse(const EntryStore &entries, int i1, int i2) const {
+    return path_entry_compare(entries, i2, i1);
 };
 
-bool DirectoryManager::name_entry_compare(const QFileInfo &e1, const QFileInfo &e2) const {
-    return m_collator.compare(e1.fileName(), e2.fileName()) < 0;
+bool DirectoryManager::name_entry_compare(const EntryStore &entries, int i1, int i2) const {
+    return entries.compareNames(i1, i2) < 0;
 };
 
-bool DirectoryManager::name_entry_compare_reverse(const QFileInfo &e1, const QFileInfo &e2) const {
-    return m_collator.compare(e1.fileName(), e2.fileName()) > 0;
+bool DirectoryManager::name_entry_compare_reverse(const EntryStore &entries, int i1, int i2) const {
+    return entries.compareNames(i1, i2) > 0;
 };
 
-bool DirectoryManager::date_entry_compare(const QFileInfo& e1, const QFileInfo& e2) const {
-    return e1.lastModified() < e2.lastModified();
+bool DirectoryManager::date_entry_compare(const EntryStore &entries, int i1, int i2) const {
+    return entries.mtime(i1) < entries.mtime(i2);
+}
+
+bool DirectoryManager::date_entry_compare_reverse(const EntryStore &entries, int i1, int i2) const {
+    return entries.mtime(i1) > entries.mtime(i2);
+}
+
+bool DirectoryManager::size_entry_compare(const EntryStore &entries, int i1, int i2) const {
+    return entries.size(i1) < entries.size(i2);
+}
+
+bool DirectoryManager::size_entry_compare_reverse(const EntryStore &entries, int i1, int i2) const {
+    return entries.size(i1) > entries.size(i2);
+}
+
+// files not indexed yet go by mtime; bursts share a timestamp, those go by name
+bool DirectoryManager::date_taken_entry_compare(const EntryStore &entries, int i1, int i2) const {
+    qint64 date1 = entries.metadata(i1).dateTaken;
+    qint64 date2 = entries.metadata(i2).dateTaken;
+    if(date1 < 0)
+        date1 = entries.mtime(i1);
+    if(date2 < 0)
+        date2 = entries.mtime(i2);
+    if(date1 != date2)
+        return date1 < date2;
+    return entries.comparePaths(i1, i2) < 0;
+}
+
+bool DirectoryManager::date_taken_entry_compare_reverse(const EntryStore &entries, int i1, int i2) const {
+    return date_taken_entry_compare(entries, i2, i1);
+}
+
+// pixel count, then name
+bool DirectoryManager::dimensions_entry_compare(const EntryStore &entries, int i1, int i2) const {
+    const QSize &size1 = entries.metadata(i1).size;
+    const QSize &size2 = entries.metadata(i2).size;
+    qint64 area1 = static_cast<qint64>(size1.width()) * size1.height();
+    qint64 area2 = static_cast<qint64>(size2.width()) * size2.height();
+    if(area1 != area2)
+        return area1 < area2;
+    return entries.comparePaths(i1, i2) < 0;
+}
+
+bool DirectoryManager::dimensions_entry_compare_reverse(const EntryStore &entries, int i1, int i2) const {
+    return dimensions_entry_compare(entries, i2, i1);
+}
+
+// camera, then name
+bool DirectoryManager::camera_entry_compare(const EntryStore &entries, int i1, int i2) const {
+    int result = entries.metadata(i1).camera.compare(entries.metadata(i2).camera, Qt::CaseInsensitive);
+    if(result)
+        return result < 0;
+    return entries.comparePaths(i1, i2) < 0;
 }
 
-bool DirectoryManager::date_entry_compare_reverse(const QFileInfo& e1, const QFileInfo& e2) const {
-    return e1.lastModified() > e2.lastModified();
+bool DirectoryManager::camera_entry_compare_reverse(const EntryStore &entries, int i1, int i2) const {
+    return camera_entry_compare(entries, i2, i1);
 }
 
-bool DirectoryManager::size_entry_compare(const QFileInfo& e1, const QFileInfo& e2) const {
-    return e1.size() < e2.size();
+bool DirectoryManager::usesMetadata(CompareFunction compare) {
+    return compare == &DirectoryManager::date_taken_entry_compare ||
+           compare == &DirectoryManager::date_taken_entry_compare_reverse ||
+           compare == &DirectoryManager::dimensions_entry_compare ||
+           compare == &DirectoryManager::dimensions_entry_compare_reverse ||
+           compare == &DirectoryManager::camera_entry_compare ||
+           compare == &DirectoryManager::camera_entry_compare_reverse;
 }
 
-bool DirectoryManager::size_entry_compare_reverse(const QFileInfo& e1, const QFileInfo& e2) const {
-    return e1.size() > e2.size();
+bool DirectoryManager::isMetadataSorting() const {
+    return mSortingMode >= SORT_DATE_TAKEN_ASC && !this->isDirectoriesMode();
+}
+
+// sorts an index permutation, then moves every column once.
+// comparators only read precomputed data, so large lists are sorted in parallel
+// returns false if the order was already right
+bool DirectoryManager::sortEntries(EntryStore &entries, CompareFunction compare) const {
+    if(entries.count() < 2)
+        return false;
+    if(usesMetadata(compare))
+        entries.loadMetadata();
+    else if(compare != &DirectoryManager::path_entry_compare && compare != &DirectoryManager::path_entry_compare_reverse)
+        entries.statAll();
+    std::vector<int> order(entries.count());
+    std::iota(order.begin(), order.end(), 0);
+    parallelSort(order.begin(), order.end(), [this, &entries, compare](int i1, int i2) {
+        return (this->*compare)(entries, i1, i2);
+    });
+    if(std::is_sorted(order.begin(), order.end()))
+        return false;
+    entries.reorder(order);
+    return true;
+}
+
+// binary search for the place of entry at `index` among [0, index), same as std::upper_bound
+int DirectoryManager::moveToSortedPosition(EntryStore &entries, int index, CompareFunction compare) {
+    int low = 0, high = index;
+    while(low < high) {
+        int mid = low + (high - low) / 2;
+        if((this->*compare)(entries, index, mid))
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    entries.move(index, low);
+    return low;
 }
 
 CompareFunction DirectoryManager::compareFunction()
@@ -70,12 +162,33 @@ CompareFunction DirectoryManager::compareFunction()
 
 		case SORT_TIME_DESC:
 			return &DirectoryManager::date_entry_compare_reverse;
+
+		case SORT_DATE_TAKEN_ASC:
+			return &DirectoryManager::date_taken_entry_compare;
+
+		case SORT_DATE_TAKEN_DESC:
+			return &DirectoryManager::date_taken_entry_compare_reverse;
+
+		case SORT_DIMENSIONS_ASC:
+			return &DirectoryManager::dimensions_entry_compare;
+
+		case SORT_DIMENSIONS_DESC:
+			return &DirectoryManager::dimensions_entry_compare_reverse;
+
+		case SORT_CAMERA_ASC:
+			return &DirectoryManager::camera_entry_compare;
+
+		case SORT_CAMERA_DESC:
+			return &DirectoryManager::camera_entry_compare_reverse;
+
+		case SORT_MODE_COUNT:
+			break;
 	}
 
 	return &DirectoryManager::path_entry_compare;
 }
 
-void DirectoryManager::startFileWatcher(QString directoryPath) {
+void DirectoryManager::startFileWatcher(QString directoryPath, bool recursive) {
     if(directoryPath == "")
         return;
 
@@ -88,7 +201,9 @@ void DirectoryManager::startFileWatcher(QString directoryPath) {
     connect(m_watcher, &DirectoryWatcher::fileDeleted, this, &DirectoryManager::onFileRemovedExternal, Qt::UniqueConnection);
     connect(m_watcher, &DirectoryWatcher::fileModified, this, &DirectoryManager::onFileModifiedExternal, Qt::UniqueConnection);
     connect(m_watcher, &DirectoryWatcher::fileRenamed, this, &DirectoryManager::onFileRenamedExternal, Qt::UniqueConnection);
+    connect(m_watcher, &DirectoryWatcher::watchLimitReached, this, &DirectoryManager::onWatchLimitReached, Qt::UniqueConnection);
 
+    m_watcher->setRecursive(recursive);
     m_watcher->setWatchPath(directoryPath);
     m_watcher->observe();
 }
@@ -103,6 +218,7 @@ void DirectoryManager::stopFileWatcher() {
     disconnect(m_watcher, &DirectoryWatcher::fileDeleted, this, &DirectoryManager::onFileRemovedExternal);
     disconnect(m_watcher, &DirectoryWatcher::fileModified, this, &DirectoryManager::onFileModifiedExternal);
     disconnect(m_watcher, &DirectoryWatcher::fileRenamed, this, &DirectoryManager::onFileRenamedExternal);
+    disconnect(m_watcher, &DirectoryWatcher::watchLimitReached, this, &DirectoryManager::onWatchLimitReached);
 }
 
 // ##############################################################
@@ -117,33 +233,255 @@ void DirectoryManager::readSettings()
 
 bool DirectoryManager::setDirectory(const QString &path, bool recursive, bool watch)
 {
-	if (path.isEmpty()) {
+	if (openDirectory(path, recursive) == false) {
 		return false;
 	}
 
-	QDir directory(path);
+	if (recursive || loadSnapshot() == false) {
+		qint64 dirMtime = ListingCache::directoryMtime(m_directory_path);
+		loadEntryList(recursive);
+		if (!recursive) {
+			saveSnapshot(dirMtime);
+		}
+	}
 
-	if (directory.isReadable() == false) {
-		emit errorOccurred(QStringLiteral("Directory is not readable: %1").arg(directory.absolutePath()));
+	emit loaded(m_directory_path);
+
+	if (watch) {
+		startFileWatcher(m_directory_path, recursive);
+	} else {
+		stopFileWatcher();
+	}
+
+	requestMetadata();
+	return true;
+}
+
+bool DirectoryManager::setDirectoryAsync(const QString &path, bool recursive, bool watch)
+{
+	if (openDirectory(path, recursive) == false) {
 		return false;
 	}
 
-	if (recursive) {
+	bool snapshotLoaded = !recursive && loadSnapshot();
+	if (!snapshotLoaded) {
+		dirEntryVec.clear();
+		fileEntryVec.clear();
+		rebuildIndex(fileIndex, fileEntryVec);
+		rebuildIndex(dirIndex, dirEntryVec);
+	}
+
+	emit loaded(m_directory_path);
+
+	// watcher events for files not listed yet just insert them early,
+	// duplicates are skipped when merging
+	if (watch) {
+		startFileWatcher(m_directory_path, recursive);
+	} else {
 		stopFileWatcher();
 	}
 
+	if (snapshotLoaded) {
+		requestMetadata();
+		return true;
+	}
+
+	m_scan_dir_mtime = recursive ? -1 : ListingCache::directoryMtime(m_directory_path);
+	m_scan_compare = compareFunction();
+	m_merge_interval = 100;
+	CompareFunction compare = m_scan_compare;
+	m_scanner.start(m_directory_path, scanOptions(recursive), [this, compare](EntryStore &entries) {
+		sortEntries(entries, compare);
+	});
+	return true;
+}
+
+bool DirectoryManager::isScanning() const
+{
+	return m_scanner.isRunning();
+}
+
+// common part of setDirectory*()
+bool DirectoryManager::openDirectory(const QString &path, bool recursive)
+{
+	cancelScan();
+
+	if (path.isEmpty()) {
+		return false;
+	}
+
+	QDir directory(path);
+
+	if (directory.isReadable() == false) {
+		emit errorOccurred(tr("Directory is not readable: %1").arg(directory.absolutePath()));
+		return false;
+	}
+
 	mListSource = recursive ? SOURCE_DIRECTORY_RECURSIVE : SOURCE_DIRECTORY;
 
 	m_directory_path = directory.absolutePath();
+	// queued events belong to the previous directory
+	m_external_events.clear();
+	m_external_timer.stop();
+	return true;
+}
+
+void DirectoryManager::cancelScan()
+{
+	if (!m_scanner.isRunning()) {
+		return;
+	}
+	m_scanner.cancel();
+	m_merge_timer.stop();
+	m_scan_batches.clear();
+	emit scanFinished(m_directory_path);
+}
 
-	loadEntryList(recursive);
+ScanOptions DirectoryManager::scanOptions(bool recursive) const
+{
+	ScanOptions options;
+	options.recursive = recursive;
+	options.directories = this->isDirectoriesMode();
+	options.hidden = settings->showHiddenFiles();
+	options.extensions = m_supported_extensions;
+	return options;
+}
 
-	emit loaded(m_directory_path);
+// `runs` are the boundaries of consecutive sorted ranges, starting at 0.
+// Merged pairwise, so k runs cost O(n log k)
+std::vector<int> DirectoryManager::mergeSortedRuns(EntryStore &entries, std::vector<int> runs, CompareFunction compare) const
+{
+	std::vector<int> order(entries.count());
+	std::iota(order.begin(), order.end(), 0);
+	auto less = [this, &entries, compare](int i1, int i2) {
+		return (this->*compare)(entries, i1, i2);
+	};
+	while (runs.size() > 2) {
+		std::vector<int> merged = { runs[0] };
+		for (size_t i = 0; i + 2 < runs.size(); i += 2) {
+			std::inplace_merge(order.begin() + runs[i], order.begin() + runs[i + 1], order.begin() + runs[i + 2], less);
+			merged.push_back(runs[i + 2]);
+		}
+		if (runs.size() % 2 == 0) {
+			merged.push_back(runs.back());
+		}
+		runs.swap(merged);
+	}
+	entries.reorder(order);
+	return order;
+}
+
+// Reuses the saved order of an unchanged directory. Only name order is taken
+// as is, sizes and times may have changed without touching the directory.
+bool DirectoryManager::loadSnapshot()
+{
+	EntryStore &entries = this->isDirectoriesMode() ? dirEntryVec : fileEntryVec;
+	SortingMode savedMode;
+	dirEntryVec.clear();
+	fileEntryVec.clear();
+	if (!ListingCache::load(m_directory_path, ListingCache::optionsKey(scanOptions(false)), entries, savedMode)) {
+		return false;
+	}
+	bool nameOrder = mSortingMode == SORT_NAME_ASC || mSortingMode == SORT_NAME_DESC;
+	if (savedMode != mSortingMode || !nameOrder) {
+		sortEntries(entries, compareFunction());
+	}
+	rebuildIndex(fileIndex, fileEntryVec);
+	rebuildIndex(dirIndex, dirEntryVec);
+	return true;
+}
+
+// written in the background from a copy. Directory lists (used to step
+// between sibling folders) are always kept, file lists only when big
+void DirectoryManager::saveSnapshot(qint64 dirMtime)
+{
+	const EntryStore &entries = this->isDirectoriesMode() ? dirEntryVec : fileEntryVec;
+	if (dirMtime < 0 || (!this->isDirectoriesMode() && entries.count() < LISTING_SNAPSHOT_MIN_FILES)) {
+		return;
+	}
+	auto snapshot = std::make_shared<EntryStore>(entries);
+	QString dirPath = m_directory_path;
+	QByteArray key = ListingCache::optionsKey(scanOptions(false));
+	SortingMode mode = mSortingMode;
+	QThreadPool::globalInstance()->start([dirPath, key, dirMtime, snapshot, mode]() {
+		ListingCache::save(dirPath, key, dirMtime, *snapshot, mode);
+	});
+}
+
+void DirectoryManager::onScanBatch(std::shared_ptr<EntryStore> batch)
+{
+	m_scan_batches.push_back(batch);
+	EntryStore &entries = this->isDirectoriesMode() ? dirEntryVec : fileEntryVec;
+	// show something as soon as possible
+	if (entries.isEmpty()) {
+		mergeScanBatches();
+		return;
+	}
+	// every merge relayouts the views; back off on big trees
+	if (!m_merge_timer.isActive()) {
+		m_merge_timer.start(m_merge_interval);
+		m_merge_interval = qMin(m_merge_interval * 2, 1600);
+	}
+}
+
+void DirectoryManager::onScanFinished()
+{
+	m_merge_timer.stop();
+	if (!mergeScanBatches() && isEmpty()) {
+		emit loaded(m_directory_path);
+	}
+	if (mListSource == SOURCE_DIRECTORY) {
+		saveSnapshot(m_scan_dir_mtime);
+	}
+	requestMetadata();
+	emit scanFinished(m_directory_path);
+}
 
-	if (watch && recursive == false) {
-		startFileWatcher(m_directory_path);
+// Appends the pending batches and merges the sorted runs (the current list,
+// then each batch) instead of sorting everything again.
+bool DirectoryManager::mergeScanBatches()
+{
+	EntryStore &entries = this->isDirectoriesMode() ? dirEntryVec : fileEntryVec;
+	EntryIndex &index = this->isDirectoriesMode() ? dirIndex : fileIndex;
+	std::vector<int> runs = { 0, entries.count() };
+	// setSortingMode() already re-sorted the list, but the scanner keeps
+	// sorting batches the way the scan started; those are small
+	CompareFunction compare = compareFunction();
+	for (auto &batch : m_scan_batches) {
+		if (compare != m_scan_compare) {
+			sortEntries(*batch, compare);
+		}
+		for (int i = 0; i < batch->count(); i++) {
+			// could be inserted by the watcher in the meantime
+			if (!index.positions.contains(batch->path(i))) {
+				entries.appendFrom(*batch, i);
+			}
+		}
+		if (entries.count() > runs.back()) {
+			runs.push_back(entries.count());
+		}
+	}
+	m_scan_batches.clear();
+	if (entries.count() == runs[1]) {
+		return false;
 	}
 
+	// everything past the old count is new
+	int oldCount = runs[1];
+	std::vector<int> order = mergeSortedRuns(entries, runs, compare);
+	rebuildIndex(index, entries);
+	QList<int> inserted;
+	inserted.reserve(entries.count() - oldCount);
+	for (int i = 0; i < static_cast<int>(order.size()); i++) {
+		if (order[i] >= oldCount) {
+			inserted.append(i);
+		}
+	}
+	if (this->isDirectoriesMode()) {
+		emit dirsInserted(inserted);
+	} else {
+		emit filesInserted(inserted);
+	}
 	return true;
 }
 
@@ -154,56 +492,61 @@ QString DirectoryManager::directoryPath() const
 
 int DirectoryManager::indexOfFile(const QFileInfo &info) const
 {
-	return fileEntryVec.indexOf(info);
+	return lookupEntry(fileIndex, fileEntryVec, info.absoluteFilePath());
 }
 
 int DirectoryManager::indexOfDir(const QFileInfo &info) const
 {
-	return dirEntryVec.indexOf(info);
+	return lookupEntry(dirIndex, dirEntryVec, info.absoluteFilePath());
 }
 
 int DirectoryManager::indexOfFile(QString filePath) const
 {
-	return indexOfFile(QFileInfo(filePath));
+	return lookupEntry(fileIndex, fileEntryVec, filePath);
 }
 
 int DirectoryManager::indexOfDir(QString dirPath) const
 {
-	return indexOfDir(QFileInfo(dirPath));
+	return lookupEntry(dirIndex, dirEntryVec, dirPath);
 }
 
-const QFileInfoList &DirectoryManager::files() const
+const EntryStore &DirectoryManager::files() const
 {
 	return fileEntryVec;
 }
 
+const EntryStore &DirectoryManager::dirs() const
+{
+	return dirEntryVec;
+}
+
 QString DirectoryManager::filePathAt(int index) const {
-    return checkFileRange(index) ? fileEntryVec.at(index).absoluteFilePath() : "";
+    return checkFileRange(index) ? fileEntryVec.path(index) : "";
 }
 
 QString DirectoryManager::fileNameAt(int index) const {
-    return checkFileRange(index) ? fileEntryVec.at(index).fileName() : "";
+    return checkFileRange(index) ? fileEntryVec.name(index) : "";
 }
 
 QString DirectoryManager::dirPathAt(int index) const {
-    return checkDirRange(index) ? dirEntryVec.at(index).absoluteFilePath() : "";
+    return checkDirRange(index) ? dirEntryVec.path(index) : "";
 }
 
 QString DirectoryManager::dirNameAt(int index) const {
-    return checkDirRange(index) ? dirEntryVec.at(index).fileName() : "";
+    return checkDirRange(index) ? dirEntryVec.name(index) : "";
 }
 
 QString DirectoryManager::firstFile() const {
     QString filePath = "";
-    if(fileEntryVec.size())
-        filePath = fileEntryVec.front().absoluteFilePath();
+    if(fileEntryVec.count())
+        filePath = fileEntryVec.path(0);
     return filePath;
 }
 
 QString DirectoryManager::lastFile() const {
     QString filePath = "";
-    if(fileEntryVec.size())
-        filePath = fileEntryVec.back().absoluteFilePath();
+    if(fileEntryVec.count())
+        filePath = fileEntryVec.path(fileEntryVec.count() - 1);
     return filePath;
 }
 
@@ -211,15 +554,15 @@ QString DirectoryManager::prevOfFile(QString filePath) const {
     QString prevFilePath = "";
     int currentIndex = indexOfFile(filePath);
     if(currentIndex > 0)
-        prevFilePath = fileEntryVec.at(currentIndex - 1).absoluteFilePath();
+        prevFilePath = fileEntryVec.path(currentIndex - 1);
     return prevFilePath;
 }
 
 QString DirectoryManager::nextOfFile(QString filePath) const {
     QString nextFilePath = "";
     int currentIndex = indexOfFile(filePath);
-    if(currentIndex >= 0 && currentIndex < fileEntryVec.size() - 1)
-        nextFilePath = fileEntryVec.at(currentIndex + 1).absoluteFilePath();
+    if(currentIndex >= 0 && currentIndex < fileEntryVec.count() - 1)
+        nextFilePath = fileEntryVec.path(currentIndex + 1);
     return nextFilePath;
 }
 
@@ -227,24 +570,24 @@ QString DirectoryManager::prevOfDir(QString dirPath) const {
     QString prevDirectoryPath = "";
     int currentIndex = indexOfDir(dirPath);
     if(currentIndex > 0)
-        prevDirectoryPath = dirEntryVec.at(currentIndex - 1).absoluteFilePath();
+        prevDirectoryPath = dirEntryVec.path(currentIndex - 1);
     return prevDirectoryPath;
 }
 
 QString DirectoryManager::nextOfDir(QString dirPath) const {
     QString nextDirectoryPath = "";
     int currentIndex = indexOfDir(dirPath);
-    if(currentIndex >= 0 && currentIndex < dirEntryVec.size() - 1)
-        nextDirectoryPath = dirEntryVec.at(currentIndex + 1).absoluteFilePath();
+    if(currentIndex >= 0 && currentIndex < dirEntryVec.count() - 1)
+        nextDirectoryPath = dirEntryVec.path(currentIndex + 1);
     return nextDirectoryPath;
 }
 
 bool DirectoryManager::checkFileRange(int index) const {
-    return index >= 0 && index < (int)fileEntryVec.size();
+    return index >= 0 && index < fileEntryVec.count();
 }
 
 bool DirectoryManager::checkDirRange(int index) const {
-    return index >= 0 && index < (int)dirEntryVec.size();
+    return index >= 0 && index < dirEntryVec.count();
 }
 
 unsigned long DirectoryManager::totalCount() const {
@@ -252,25 +595,20 @@ unsigned long DirectoryManager::totalCount() const {
 }
 
 unsigned long DirectoryManager::fileCount() const {
-    return fileEntryVec.size();
+    return fileEntryVec.count();
 }
 
 unsigned long DirectoryManager::dirCount() const {
-    return dirEntryVec.size();
+    return dirEntryVec.count();
 }
 
-const QFileInfo &DirectoryManager::fileEntryAt(int index) const {
-    if(checkFileRange(index))
-        return fileEntryVec.at(index);
-    else
-        return defaultEntry;
+qint64 DirectoryManager::fileSizeAt(int index) const {
+    return checkFileRange(index) ? fileEntryVec.size(index) : 0;
 }
 
 QDateTime DirectoryManager::lastModified(QString filePath) const {
-    QFileInfo info;
-    if(containsFile(filePath))
-        info.setFile(filePath);
-    return info.lastModified();
+    int index = indexOfFile(filePath);
+    return (index == -1) ? QDateTime() : fileEntryVec.lastModified(index);
 }
 
 bool DirectoryManager::isSupportedFile(QString path) const
@@ -291,7 +629,7 @@ bool DirectoryManager::isDir(QString path) const {
 }
 
 bool DirectoryManager::isEmpty() const {
-    return fileEntryVec.empty();
+    return fileEntryVec.isEmpty();
 }
 
 
@@ -302,22 +640,22 @@ bool DirectoryManager::isSupportedExtension(const QString &extension) const
 
 bool DirectoryManager::containsFile(const QFileInfo &info) const
 {
-	return constFindFile(info) != fileEntryVec.end();
+	return fileIndex.positions.contains(entryKey(info.absoluteFilePath()));
 }
 
 bool DirectoryManager::containsFile(const QString &path) const
 {
-	return constFindFile(path) != fileEntryVec.end();
+	return fileIndex.positions.contains(entryKey(path));
 }
 
 bool DirectoryManager::containsDir(const QFileInfo &info) const
 {
-	return constFindDirectory(info) != dirEntryVec.end();
+	return dirIndex.positions.contains(entryKey(info.absoluteFilePath()));
 }
 
 bool DirectoryManager::containsDir(const QString &path) const
 {
-	return constFindDirectory(path) != dirEntryVec.end();
+	return dirIndex.positions.contains(entryKey(path));
 }
 
 // ##############################################################
@@ -329,6 +667,8 @@ void DirectoryManager::loadEntryList(const QString &directory, bool recursive)
 	dirEntryVec.clear();
 	fileEntryVec.clear();
 	addEntriesFromDirectory(directory, recursive);
+	rebuildIndex(fileIndex, fileEntryVec);
+	rebuildIndex(dirIndex, dirEntryVec);
 }
 
 void DirectoryManager::loadEntryList(bool recursive)
@@ -336,69 +676,66 @@ void DirectoryManager::loadEntryList(bool recursive)
 	loadEntryList(m_directory_path, recursive);
 }
 
-void DirectoryManager::addEntriesFromDirectory(const QString &path, bool recursive)
+// synchronous version of the scan, same reader
+void DirectoryManager::readEntries(const QString &path, bool recursive, EntryStore &entries) const
 {
-	QDir::Filters filters = QDir::NoDotAndDotDot;
-
-	if (this->isDirectoriesMode()) {
-		filters |= QDir::AllDirs;
-	} else {
-		filters |= QDir::Files;
-	}
-
-	if (settings->showHiddenFiles()) {
-		filters |= QDir::Hidden;
-	}
-
-	QDirIterator iterator(path, filters, recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
-	QFileInfoList list;
-
-	list.reserve(100);
-
-	if (this->isDirectoriesMode()) {
-		while (iterator.hasNext()) {
-			list << iterator.nextFileInfo();
-		}
-	} else {
-		while (iterator.hasNext()) {
-			QFileInfo info = iterator.nextFileInfo();
-			if (this->isSupportedExtension(info.suffix())) {
-				list << info;
-			}
-		}
+	ScanOptions options = scanOptions(recursive);
+	QStringList directories = { QDir(path).absolutePath() };
+	while (!directories.isEmpty()) {
+		DirectoryScanner::readDirectory(directories.takeFirst(), options, entries, directories);
 	}
+}
 
-	if (list.isEmpty()) {
-		return;
-	}
-
-	std::sort(list.begin(), list.end(), std::bind(compareFunction(), this, std::placeholders::_1, std::placeholders::_2));
-
-	QFileInfoList &entries = this->isDirectoriesMode() ? dirEntryVec : fileEntryVec;
-
-	entries.reserve(entries.size() + list.size());
-
-	for (const QFileInfo &info : list) {
-		entries.emplace_back(info);
-	}
+void DirectoryManager::addEntriesFromDirectory(const QString &path, bool recursive)
+{
+	EntryStore &entries = this->isDirectoriesMode() ? dirEntryVec : fileEntryVec;
+	readEntries(path, recursive, entries);
+	sortEntries(entries, compareFunction());
 }
 
 void DirectoryManager::sortEntryLists() {
     if(settings->sortFolders())
-        std::sort(dirEntryVec.begin(), dirEntryVec.end(), std::bind(compareFunction(), this, std::placeholders::_1, std::placeholders::_2));
+        sortEntries(dirEntryVec, compareFunction());
     else
-        std::sort(dirEntryVec.begin(), dirEntryVec.end(), std::bind(&DirectoryManager::path_entry_compare, this, std::placeholders::_1, std::placeholders::_2));
-    std::sort(fileEntryVec.begin(), fileEntryVec.end(), std::bind(compareFunction(), this, std::placeholders::_1, std::placeholders::_2));
+        sortEntries(dirEntryVec, &DirectoryManager::path_entry_compare);
+    sortEntries(fileEntryVec, compareFunction());
+    rebuildIndex(fileIndex, fileEntryVec);
+    rebuildIndex(dirIndex, dirEntryVec);
 }
 
 void DirectoryManager::setSortingMode(SortingMode mode) {
     if(mode != mSortingMode) {
         mSortingMode = mode;
-        if(fileEntryVec.size() > 1 || dirEntryVec.size() > 1) {
+        if(fileEntryVec.count() > 1 || dirEntryVec.count() > 1) {
             sortEntryLists();
             emit sortingChanged();
         }
+        requestMetadata();
+    }
+}
+
+// Queues files missing from the metadata index; the list gets sorted again
+// once they are in. Until then they are sorted as if they had no metadata
+void DirectoryManager::requestMetadata() {
+    if(!metadataIndex || !isMetadataSorting() || isScanning())
+        return;
+    QList<MetadataRequest> requests;
+    for(int i = 0; i < fileEntryVec.count(); i++) {
+        if(!fileEntryVec.hasMetadata(i))
+            requests.append(MetadataRequest{ fileEntryVec.path(i), fileEntryVec.metadataKey(i) });
     }
+    if(!requests.isEmpty())
+        metadataIndex->request(requests);
+}
+
+void DirectoryManager::onMetadataIndexUpdated() {
+    if(!isMetadataSorting() || fileEntryVec.count() < 2)
+        return;
+    fileEntryVec.clearMetadata();
+    if(!sortEntries(fileEntryVec, compareFunction()))
+        return;
+    rebuildIndex(fileIndex, fileEntryVec);
+    emit orderChanged();
 }
 
 SortingMode DirectoryManager::sortingMode() const {
@@ -420,7 +757,8 @@ bool DirectoryManager::forceInsertFileEntry(const QString &filePath)
 	if (info.isFile() == false || this->containsFile(info)) {
 		return false;
 	}
-  insert_sorted(fileEntryVec, info, std::bind(compareFunction(), this, std::placeholders::_1, std::placeholders::_2));
+  int index = moveToSortedPosition(fileEntryVec, fileEntryVec.append(info), compareFunction());
+  entryInserted(fileIndex, fileEntryVec.path(index), index);
   if(!directoryPath().isEmpty()) {
       qDebug() << "fileIns" << filePath << directoryPath();
       emit fileAdded(filePath);
@@ -430,26 +768,25 @@ bool DirectoryManager::forceInsertFileEntry(const QString &filePath)
 
 void DirectoryManager::removeFileEntry(const QString &filePath)
 {
-	QFileInfoList::const_iterator info = constFindFile(filePath);
-	if (info == fileEntryVec.constEnd()) {
+	int index = indexOfFile(filePath);
+	if (index == -1) {
 		return;
 	}
 
-	uint index = std::distance(fileEntryVec.constBegin(), info);
-
-	fileEntryVec.erase(info);
+	entryRemoved(fileIndex, fileEntryVec.path(index), index);
+	fileEntryVec.remove(index);
 
   emit fileRemoved(filePath, index);
 }
 
 void DirectoryManager::updateFileEntry(const QString &filePath)
 {
-	QFileInfoList::iterator info = findFile(filePath);
-	if (info == fileEntryVec.end()) {
+	int index = indexOfFile(filePath);
+	if (index == -1) {
 		return;
 	}
 
-	info->refresh();
+	fileEntryVec.refresh(index);
 
 	emit fileModified(filePath);
 }
@@ -470,16 +807,19 @@ void DirectoryManager::renameFileEntry(const QString &oldFilePath, const QString
     }
     if(containsFile(newFilePath)) {
         int replaceIndex = indexOfFile(newFilePath);
-        fileEntryVec.erase(fileEntryVec.begin() + replaceIndex);
+        entryRemoved(fileIndex, fileEntryVec.path(replaceIndex), replaceIndex);
+        fileEntryVec.remove(replaceIndex);
         emit fileRemoved(newFilePath, replaceIndex);
     }
     // remove the old one
     int oldIndex = indexOfFile(oldFilePath);
-    fileEntryVec.erase(fileEntryVec.begin() + oldIndex);
+    entryRemoved(fileIndex, fileEntryVec.path(oldIndex), oldIndex);
+    fileEntryVec.remove(oldIndex);
     // insert
-    insert_sorted(fileEntryVec, QFileInfo(newFilePath), std::bind(compareFunction(), this, std::placeholders::_1, std::placeholders::_2));
+    int newIndex = moveToSortedPosition(fileEntryVec, fileEntryVec.append(QFileInfo(newFilePath)), compareFunction());
+    entryInserted(fileIndex, fileEntryVec.path(newIndex), newIndex);
     qDebug() << "fileRen" << oldFilePath << newFilePath;
-    emit fileRenamed(oldFilePath, oldIndex, newFilePath, indexOfFile(newFilePath));
+    emit fileRenamed(oldFilePath, oldIndex, newFilePath, newIndex);
 }
 
 // ---- dir entries
@@ -488,7 +828,8 @@ bool DirectoryManager::insertDirEntry(const QString &dirPath) {
     if(containsDir(dirPath))
         return false;
 
-    insert_sorted(dirEntryVec, QFileInfo(dirPath), std::bind(compareFunction(), this, std::placeholders::_1, std::placeholders::_2));
+    int index = moveToSortedPosition(dirEntryVec, dirEntryVec.append(QFileInfo(dirPath)), compareFunction());
+    entryInserted(dirIndex, dirEntryVec.path(index), index);
     emit dirAdded(dirPath);
     return true;
 }
@@ -497,7 +838,8 @@ void DirectoryManager::removeDirEntry(const QString &dirPath) {
     if(!containsDir(dirPath))
         return;
     int index = indexOfDir(dirPath);
-    dirEntryVec.erase(dirEntryVec.begin() + index);
+    entryRemoved(dirIndex, dirEntryVec.path(index), index);
+    dirEntryVec.remove(index);
     qDebug() << "dirRem" << dirPath;
     emit dirRemoved(dirPath, index);
 }
@@ -509,10 +851,12 @@ void DirectoryManager::renameDirEntry(const QString &oldDirPath, const QString &
     QString newDirPath = fi.absolutePath() + "/" + newDirName;
     // remove the old one
     int oldIndex = indexOfDir(oldDirPath);
-    dirEntryVec.erase(dirEntryVec.begin() + oldIndex);
+    entryRemoved(dirIndex, dirEntryVec.path(oldIndex), oldIndex);
+    dirEntryVec.remove(oldIndex);
     // insert
-	insert_sorted(dirEntryVec, QFileInfo(newDirPath), std::bind(compareFunction(), this, std::placeholders::_1, std::placeholders::_2));
-  emit dirRenamed(oldDirPath, oldIndex, newDirPath, indexOfDir(newDirPath));
+    int newIndex = moveToSortedPosition(dirEntryVec, dirEntryVec.append(QFileInfo(newDirPath)), compareFunction());
+    entryInserted(dirIndex, dirEntryVec.path(newIndex), newIndex);
+  emit dirRenamed(oldDirPath, oldIndex, newDirPath, newIndex);
 }
 
 
@@ -525,34 +869,241 @@ bool DirectoryManager::fileWatcherActive()
 	return m_watcher && m_watcher->isObserving();
 }
 
+// ---- subtrees (recursive mode)
+
+// a directory appeared somewhere below the root
+void DirectoryManager::insertFileSubtree(const QString &dirPath)
+{
+	EntryStore entries;
+	readEntries(dirPath, true, entries);
+	for (int i = 0; i < entries.count(); i++) {
+		forceInsertFileEntry(entries.path(i));
+	}
+}
+
+void DirectoryManager::removeFileSubtree(const QString &dirPath)
+{
+	QString prefix = dirPath + "/";
+	// backwards, so the reported indexes stay valid one by one
+	for (int i = fileEntryVec.count() - 1; i >= 0; i--) {
+		const QString &parent = fileEntryVec.dirPath(i);
+		if (parent == dirPath || parent.startsWith(prefix)) {
+			QString filePath = fileEntryVec.path(i);
+			entryRemoved(fileIndex, filePath, i);
+			fileEntryVec.remove(i);
+			emit fileRemoved(filePath, i);
+		}
+	}
+}
+
+void DirectoryManager::onWatchLimitReached()
+{
+	emit errorOccurred(tr("Too many subdirectories to watch in %1, some changes will not be picked up").arg(m_directory_path));
+}
+
 //----------------------------------------------------------------------------
 // fs m_watcher events  ( onFile___External() )
-// these take file NAMES, not paths
+// these take file NAMES, not paths.
+// In recursive mode names are relative to the watch path and may include subdirectories.
+// Events are queued and applied together, see flushExternalEvents()
 void DirectoryManager::onFileRemovedExternal(QString fileName) {
-    QString fullPath = m_watcher->watchPath() + "/" + fileName;
-    removeDirEntry(fullPath);
-    removeFileEntry(fullPath);
+    queueExternalEvent({ CHANGE_REMOVED, m_watcher->watchPath() + "/" + fileName, QString() });
 }
 
 void DirectoryManager::onFileAddedExternal(QString fileName) {
-    QString fullPath = m_watcher->watchPath() + "/" + fileName;
-    if(isDir(fullPath))
-        insertDirEntry(fullPath);
-    else
-        insertFileEntry(fullPath);
+    queueExternalEvent({ CHANGE_ADDED, m_watcher->watchPath() + "/" + fileName, QString() });
 }
 
 void DirectoryManager::onFileRenamedExternal(QString oldName, QString newName) {
-    QString oldPath = m_watcher->watchPath() + "/" + oldName;
-    QString newPath = m_watcher->watchPath() + "/" + newName;
-    if(isDir(newPath))
-        renameDirEntry(oldPath, newName);
-    else
-        renameFileEntry(oldPath, newName);
+    queueExternalEvent({ CHANGE_RENAMED, m_watcher->watchPath() + "/" + oldName, m_watcher->watchPath() + "/" + newName });
 }
 
 void DirectoryManager::onFileModifiedExternal(QString fileName) {
-    updateFileEntry(m_watcher->watchPath() + "/" + fileName);
+    queueExternalEvent({ CHANGE_MODIFIED, m_watcher->watchPath() + "/" + fileName, QString() });
+}
+
+// Waits for a pause in the event stream, but never longer than
+// EXTERNAL_EVENTS_MAX_DELAY since the first queued event
+void DirectoryManager::queueExternalEvent(const ExternalEvent &event) {
+    if(m_external_events.isEmpty())
+        m_external_age.start();
+    m_external_events.append(event);
+    if(!m_external_timer.isActive() || m_external_age.elapsed() < EXTERNAL_EVENTS_MAX_DELAY)
+        m_external_timer.start(EXTERNAL_EVENTS_DELAY);
+}
+
+void DirectoryManager::flushExternalEvents() {
+    QList<ExternalEvent> events;
+    events.swap(m_external_events);
+    m_external_timer.stop();
+    // a few changes: keep the precise per-item updates (renames etc)
+    if(events.count() < EXTERNAL_EVENTS_BATCH_MIN) {
+        for(auto &event : events)
+            applyExternalEvent(event);
+        return;
+    }
+    applyExternalEvents(events);
+}
+
+void DirectoryManager::applyExternalEvent(const ExternalEvent &event) {
+    switch(event.type) {
+    case CHANGE_ADDED:
+        if(isDir(event.path)) {
+            if(mListSource == SOURCE_DIRECTORY_RECURSIVE)
+                insertFileSubtree(event.path);
+            else
+                insertDirEntry(event.path);
+        } else {
+            insertFileEntry(event.path);
+        }
+        break;
+    case CHANGE_REMOVED:
+        removeDirEntry(event.path);
+        removeFileEntry(event.path);
+        if(mListSource == SOURCE_DIRECTORY_RECURSIVE)
+            removeFileSubtree(event.path);
+        break;
+    case CHANGE_MODIFIED:
+        updateFileEntry(event.path);
+        break;
+    case CHANGE_RENAMED: {
+        QFileInfo newInfo(event.newPath);
+        if(isDir(event.newPath)) {
+            if(mListSource == SOURCE_DIRECTORY_RECURSIVE) {
+                removeFileSubtree(event.path);
+                insertFileSubtree(event.newPath);
+            } else {
+                renameDirEntry(event.path, newInfo.fileName());
+            }
+        } else if(QFileInfo(event.path).absolutePath() != newInfo.absolutePath()) {
+            // moved between subdirectories
+            removeFileEntry(event.path);
+            insertFileEntry(event.newPath);
+        } else {
+            renameFileEntry(event.path, newInfo.fileName());
+        }
+        break;
+    }
+    }
+}
+
+// Bulk version. Events are reduced to their net effect per path, directories
+// still go one by one; files are removed in one pass (in recursive mode with
+// those of removed directories), new ones sorted among themselves and merged in.
+// Listeners get a single filesChanged().
+void DirectoryManager::applyExternalEvents(const QList<ExternalEvent> &events) {
+    QHash<QString, ExternalChange> changes;
+    auto note = [&changes](const QString &path, ExternalChange type) {
+        auto it = changes.find(path);
+        if(it == changes.end())
+            changes.insert(path, type);
+        else if(type != CHANGE_MODIFIED)
+            it.value() = type;
+        else if(it.value() == CHANGE_ADDED)
+            return;
+        else
+            it.value() = type;
+    };
+    for(auto &event : events) {
+        if(event.type == CHANGE_RENAMED) {
+            note(event.path, CHANGE_REMOVED);
+            note(event.newPath, CHANGE_ADDED);
+        } else {
+            note(event.path, event.type);
+        }
+    }
+
+    bool recursive = mListSource == SOURCE_DIRECTORY_RECURSIVE;
+    QStringList removedPaths, modifiedPaths;
+    // recursive mode: removed paths that may have been directories
+    QSet<QString> removedDirs;
+    QList<QFileInfo> addedFiles;
+    for(auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        const QString &path = it.key();
+        if(it.value() == CHANGE_REMOVED) {
+            if(containsFile(path)) {
+                removedPaths << path;
+            } else if(recursive) {
+                if(containsDir(path))
+                    removeDirEntry(path);
+                removedDirs.insert(path);
+            } else if(containsDir(path)) {
+                applyExternalEvent({ CHANGE_REMOVED, path, QString() });
+            }
+        } else if(containsFile(path)) {
+            // replaced or modified
+            modifiedPaths << path;
+        } else if(it.value() == CHANGE_ADDED) {
+            QFileInfo info(path);
+            if(info.isDir()) {
+                applyExternalEvent({ CHANGE_ADDED, path, QString() });
+            } else if(info.isFile() && (info.isSymLink() ? isSupportedFile(path) : isSupportedExtension(info.suffix()))) {
+                addedFiles << info;
+            }
+        }
+    }
+
+    // files under removed directories join the batch; one pass for all of them
+    if(!removedDirs.isEmpty()) {
+        for(int i = 0; i < fileEntryVec.count(); i++) {
+            QString dir = fileEntryVec.dirPath(i);
+            while(dir.length() > m_directory_path.length()) {
+                if(removedDirs.contains(dir)) {
+                    auto change = changes.constFind(fileEntryVec.path(i));
+                    if(change == changes.constEnd() || change.value() != CHANGE_REMOVED)
+                        removedPaths << fileEntryVec.path(i);
+                    break;
+                }
+                dir.truncate(dir.lastIndexOf('/'));
+            }
+        }
+    }
+
+    int previousCount = fileEntryVec.count();
+    // removals: one pass, keeping the order
+    QList<int> removedAt;
+    if(!removedPaths.isEmpty()) {
+        std::vector<bool> removed(fileEntryVec.count(), false);
+        QList<int> removedIndexes;
+        // directory events above may have changed the list
+        removedPaths.erase(std::remove_if(removedPaths.begin(), removedPaths.end(), [this](const QString &path) {
+            return !containsFile(path);
+        }), removedPaths.end());
+        for(auto &path : removedPaths) {
+            int index = indexOfFile(path);
+            removed[index] = true;
+            removedIndexes << index;
+        }
+        std::vector<int> keep;
+        keep.reserve(fileEntryVec.count());
+        std::vector<int> removedBefore(fileEntryVec.count());
+        for(int i = 0; i < fileEntryVec.count(); i++) {
+            removedBefore[i] = i - static_cast<int>(keep.size());
+            if(!removed[i])
+                keep.push_back(i);
+        }
+        // where the next remaining file ends up
+        for(int index : removedIndexes)
+            removedAt << index - removedBefore[index];
+        fileEntryVec.reorder(keep);
+    }
+    // additions: sort the new ones, then merge two sorted runs
+    if(!addedFiles.isEmpty()) {
+        EntryStore added;
+        for(auto &info : addedFiles)
+            added.append(info);
+        sortEntries(added, compareFunction());
+        int oldCount = fileEntryVec.count();
+        for(int i = 0; i < added.count(); i++)
+            fileEntryVec.appendFrom(added, i);
+        mergeSortedRuns(fileEntryVec, { 0, oldCount, fileEntryVec.count() }, compareFunction());
+    }
+    if(!removedPaths.isEmpty() || !addedFiles.isEmpty()) {
+        rebuildIndex(fileIndex, fileEntryVec);
+        emit filesChanged(removedPaths, removedAt, previousCount);
+    }
+    for(auto &path : modifiedPaths)
+        updateFileEntry(path);
 }
 
 bool DirectoryManager::isDirectoriesMode() const
@@ -565,47 +1116,65 @@ void DirectoryManager::setDirectoriesMode(bool directories_mode)
 	m_directories_mode = directories_mode;
 }
 
-QFileInfoList::const_iterator DirectoryManager::constFindFile(const QString &path) const
-{
-	return std::find_if(fileEntryVec.constBegin(), fileEntryVec.constEnd(), [&] (const QFileInfo &info){
-		return info.absoluteFilePath() == path;
-	});
-}
+// ---- path index
+// stored paths are already clean & absolute
 
-QFileInfoList::const_iterator DirectoryManager::constFindDirectory(const QString &path) const
+QString DirectoryManager::entryKey(const QString &path)
 {
-	return std::find_if(dirEntryVec.constBegin(), dirEntryVec.constEnd(), [&] (const QFileInfo &info){
-		return info.absoluteFilePath() == path;
-	});
+	if (QDir::isRelativePath(path)) {
+		return QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+	}
+	return QDir::cleanPath(path);
 }
 
-QFileInfoList::const_iterator DirectoryManager::constFindFile(const QFileInfo &info) const
+int DirectoryManager::lookupEntry(EntryIndex &index, const EntryStore &entries, const QString &path) const
 {
-	return std::find(fileEntryVec.begin(), fileEntryVec.end(), info);
+	QString key = entryKey(path);
+	auto it = index.positions.constFind(key);
+	if (it == index.positions.constEnd()) {
+		return -1;
+	}
+	if (it.value() < index.validUpTo) {
+		return it.value();
+	}
+	// renumber everything after the first change since the last lookup
+	for (int i = index.validUpTo; i < entries.count(); i++) {
+		index.positions[entries.path(i)] = i;
+	}
+	index.validUpTo = entries.count();
+	return index.positions.value(key, -1);
 }
 
-QFileInfoList::const_iterator DirectoryManager::constFindDirectory(const QFileInfo &info) const
+void DirectoryManager::rebuildIndex(EntryIndex &index, const EntryStore &entries)
 {
-	return std::find(dirEntryVec.begin(), dirEntryVec.end(), info);
+	index.positions.clear();
+	index.positions.reserve(entries.count());
+	for (int i = 0; i < entries.count(); i++) {
+		index.positions.insert(entries.path(i), i);
+	}
+	index.validUpTo = entries.count();
 }
 
-QFileInfoList::iterator DirectoryManager::findFile(const QString &path)
+void DirectoryManager::entryInserted(EntryIndex &index, const QString &path, int pos)
 {
-	return std::find_if(fileEntryVec.begin(), fileEntryVec.end(), [&] (const QFileInfo &info){
-		return info.absoluteFilePath() == path;
-	});
+	index.positions.insert(entryKey(path), pos);
+	index.validUpTo = qMin(index.validUpTo, pos);
 }
 
-QFileInfoList::iterator DirectoryManager::findDirectory(const QString &path)
+void DirectoryManager::entryRemoved(EntryIndex &index, const QString &path, int pos)
 {
-	return std::find_if(dirEntryVec.begin(), dirEntryVec.end(), [&] (const QFileInfo &info){
-		return info.absoluteFilePath() == path;
-	});
+	index.positions.remove(entryKey(path));
+	index.validUpTo = qMin(index.validUpTo, pos);
 }
 
 void DirectoryManager::clear()
 {
+	cancelScan();
+	m_external_events.clear();
+	m_external_timer.stop();
 	dirEntryVec.clear();
 	fileEntryVec.clear();
+	rebuildIndex(fileIndex, fileEntryVec);
+	rebuildIndex(dirIndex, dirEntryVec);
 	m_directory_path.clear();
 }
@@ -1,21 +1,28 @@
 #pragma once
 
 #include <QCollator>
+#include <QHash>
 #include <QElapsedTimer>
 #include <QString>
 #include <QSize>
 #include <QDateTime>
 #include <QRegularExpression>
+#include <QTimer>
 
 #include <vector>
 #include <string>
 #include <iostream>
 #include <filesystem>
 #include <algorithm>
+#include <numeric>
 
 #include "settings.h"
 #include "watchers/directorywatcher.h"
+#include "entrystore.h"
+#include "directoryscanner.h"
+#include "listingcache.h"
 #include "utils/stuff.h"
+#include "utils/parallelsort.h"
 
 #ifdef Q_OS_WIN32
 #include "windows.h"
@@ -29,7 +36,36 @@ enum FileListSource { // rename? wip
 
 class DirectoryManager;
 
-typedef bool (DirectoryManager::*CompareFunction)(const QFileInfo &info1, const QFileInfo &info2) const;
+// watcher events are applied in one batch from this many on
+#define EXTERNAL_EVENTS_BATCH_MIN 16
+// ms of quiet before queued watcher events are applied
+#define EXTERNAL_EVENTS_DELAY 50
+// ms, upper bound while events keep coming
+#define EXTERNAL_EVENTS_MAX_DELAY 300
+
+enum ExternalChange {
+    CHANGE_ADDED,
+    CHANGE_REMOVED,
+    CHANGE_MODIFIED,
+    CHANGE_RENAMED
+};
+
+struct ExternalEvent {
+    ExternalChange type;
+    QString path;
+    // CHANGE_RENAMED only
+    QString newPath;
+};
+
+typedef bool (DirectoryManager::*CompareFunction)(const EntryStore &entries, int index1, int index2) const;
+
+// path -> position lookup for an entry list.
+// Membership is always exact; positions at or after validUpTo may be stale
+// and get renumbered on the next lookup that hits them
+struct EntryIndex {
+    QHash<QString, int> positions;
+    int validUpTo = 0;
+};
 
 //TODO: rename? EntrySomething?
 
@@ -39,11 +75,17 @@ public:
     DirectoryManager();
 
 	bool setDirectory(const QString &path, bool recursive = false, bool watch = true);
+	// Same, but the listing is read in the background and merged in sorted chunks.
+	// loaded() is emitted right away, each merged batch then emits filesInserted()
+	// (dirsInserted() in directories mode).
+	bool setDirectoryAsync(const QString &path, bool recursive = false, bool watch = true);
+	bool isScanning() const;
 
 	[[nodiscard]] int indexOfFile(const QFileInfo &info) const;
 	[[nodiscard]] int indexOfDir(const QFileInfo &info) const;
 
-	const QFileInfoList &files() const;
+	const EntryStore &files() const;
+	const EntryStore &dirs() const;
 
 	void clear();
 
@@ -75,12 +117,14 @@ public:
     QString lastFile() const;
     void setSortingMode(SortingMode mode);
     SortingMode sortingMode() const;
+    // sorted by something read from the file contents
+    bool isMetadataSorting() const;
 
     bool isDir(QString path) const;
 
     unsigned long totalCount() const;
 
-    const QFileInfo &fileEntryAt(int index) const;
+    qint64 fileSizeAt(int index) const;
     QString dirPathAt(int index) const;
     QString dirNameAt(int index) const;
     bool fileWatcherActive();
@@ -104,12 +148,25 @@ public:
 
 private:
 	QString m_directory_path;
-	QCollator m_collator;
-	QFileInfoList fileEntryVec, dirEntryVec;
-    const QFileInfo defaultEntry;
+	EntryStore fileEntryVec, dirEntryVec;
+    mutable EntryIndex fileIndex, dirIndex;
 
 	DirectoryWatcher *m_watcher = nullptr;
 
+	DirectoryScanner m_scanner;
+	// batches received since the last merge
+	std::vector<std::shared_ptr<EntryStore>> m_scan_batches;
+	// order the batches were sorted in
+	CompareFunction m_scan_compare = nullptr;
+	QTimer m_merge_timer;
+	int m_merge_interval;
+	// directory mtime before the scan started, for the snapshot
+	qint64 m_scan_dir_mtime = -1;
+
+	QList<ExternalEvent> m_external_events;
+	QTimer m_external_timer;
+	QElapsedTimer m_external_age;
+
     void readSettings();
     SortingMode mSortingMode = SORT_NAME_ASC;
     FileListSource mListSource;
@@ -122,31 +179,59 @@ public:
 	void setDirectoriesMode(bool directories_mode);
 
 private:
-	[[nodiscard]] QFileInfoList::const_iterator constFindFile(const QString &path) const;
-	[[nodiscard]] QFileInfoList::const_iterator constFindDirectory(const QString &path) const;
-	[[nodiscard]] QFileInfoList::const_iterator constFindFile(const QFileInfo &info) const;
-	[[nodiscard]] QFileInfoList::const_iterator constFindDirectory(const QFileInfo &info) const;
-	[[nodiscard]] QFileInfoList::iterator findFile(const QString &path);
-	[[nodiscard]] QFileInfoList::iterator findDirectory(const QString &path);
-
+	static QString entryKey(const QString &path);
+	int lookupEntry(EntryIndex &index, const EntryStore &entries, const QString &path) const;
+	void rebuildIndex(EntryIndex &index, const EntryStore &entries);
+	void entryInserted(EntryIndex &index, const QString &path, int pos);
+	void entryRemoved(EntryIndex &index, const QString &path, int pos);
+
+	bool openDirectory(const QString &path, bool recursive);
+	void cancelScan();
+	ScanOptions scanOptions(bool recursive) const;
+	bool loadSnapshot();
+	void saveSnapshot(qint64 dirMtime);
 	void loadEntryList(const QString &directory, bool recursive);
 	void loadEntryList(bool recursive);
 
-    bool path_entry_compare(const QFileInfo &e1, const QFileInfo &e2) const;
-    bool path_entry_compare_reverse(const QFileInfo &e1, const QFileInfo &e2) const;
-    bool name_entry_compare(const QFileInfo &e1, const QFileInfo &e2) const;
-    bool name_entry_compare_reverse(const QFileInfo &e1, const QFileInfo &e2) const;
-    bool date_entry_compare(const QFileInfo &e1, const QFileInfo &e2) const;
-    bool date_entry_compare_reverse(const QFileInfo &e1, const QFileInfo &e2) const;
+    bool path_entry_compare(const EntryStore &entries, int i1, int i2) const;
+    bool path_entry_compare_reverse(const EntryStore &entries, int i1, int i2) const;
+    bool name_entry_compare(const EntryStore &entries, int i1, int i2) const;
+    bool name_entry_compare_reverse(const EntryStore &entries, int i1, int i2) const;
+    bool date_entry_compare(const EntryStore &entries, int i1, int i2) const;
+    bool date_entry_compare_reverse(const EntryStore &entries, int i1, int i2) const;
     CompareFunction compareFunction();
-    bool size_entry_compare(const QFileInfo &e1, const QFileInfo &e2) const;
-    bool size_entry_compare_reverse(const QFileInfo &e1, const QFileInfo &e2) const;
-    void startFileWatcher(QString directoryPath);
+    bool size_entry_compare(const EntryStore &entries, int i1, int i2) const;
+    bool size_entry_compare_reverse(const EntryStore &entries, int i1, int i2) const;
+    bool date_taken_entry_compare(const EntryStore &entries, int i1, int i2) const;
+    bool date_taken_entry_compare_reverse(const EntryStore &entries, int i1, int i2) const;
+    bool dimensions_entry_compare(const EntryStore &entries, int i1, int i2) const;
+    bool dimensions_entry_compare_reverse(const EntryStore &entries, int i1, int i2) const;
+    bool camera_entry_compare(const EntryStore &entries, int i1, int i2) const;
+    bool camera_entry_compare_reverse(const EntryStore &entries, int i1, int i2) const;
+    static bool usesMetadata(CompareFunction compare);
+    void requestMetadata();
+    bool sortEntries(EntryStore &entries, CompareFunction compare) const;
+    int moveToSortedPosition(EntryStore &entries, int index, CompareFunction compare);
+    void startFileWatcher(QString directoryPath, bool recursive = false);
     void stopFileWatcher();
 
+	void readEntries(const QString &path, bool recursive, EntryStore &entries) const;
 	void addEntriesFromDirectory(const QString &path, bool recursive = false);
+	void insertFileSubtree(const QString &dirPath);
+	// returns the applied order: new position -> previous position
+	std::vector<int> mergeSortedRuns(EntryStore &entries, std::vector<int> runs, CompareFunction compare) const;
+	void queueExternalEvent(const ExternalEvent &event);
+	void applyExternalEvent(const ExternalEvent &event);
+	void applyExternalEvents(const QList<ExternalEvent> &events);
+	void removeFileSubtree(const QString &dirPath);
 
 private slots:
+    void onScanBatch(std::shared_ptr<EntryStore> batch);
+    void onScanFinished();
+    bool mergeScanBatches();
+    void flushExternalEvents();
+    void onWatchLimitReached();
+    void onMetadataIndexUpdated();
     void onFileAddedExternal(QString fileName);
     void onFileRemovedExternal(QString fileName);
     void onFileModifiedExternal(QString fileName);
@@ -156,11 +241,20 @@ signals:
 	void errorOccurred(const QString &message);
 
     void loaded(const QString &path);
+    // a streamed batch got merged in; new positions, ascending
+    void filesInserted(QList<int> indexes);
+    void dirsInserted(QList<int> indexes);
+    // also emitted when a running scan gets abandoned
+    void scanFinished(const QString &path);
     void sortingChanged();
+    // same sorting mode, but newly indexed metadata moved files around
+    void orderChanged();
     void fileRemoved(QString filePath, int);
     void fileModified(QString filePath);
     void fileAdded(QString filePath);
     void fileRenamed(QString fromPath, int indexFrom, QString toPath, int indexTo);
+    // batched watcher changes; removedAt: where the following file is now
+    void filesChanged(QStringList removedPaths, QList<int> removedAt, int previousCount);
 
     void dirRemoved(QString dirPath, int);
     void dirAdded(QString dirPath);
@@ -0,0 +1,269 @@
+#include "directoryscanner.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QMetaObject>
+#include <QThread>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <cstring>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/syscall.h>
+#endif
+
+struct ScanState {
+    int generation;
+    ScanOptions options;
+    std::function<void(EntryStore&)> sortBatch;
+    // directories queued or being read
+    std::atomic<int> pending{0};
+    std::atomic<bool> cancelled{false};
+};
+
+DirectoryScanner::DirectoryScanner(QObject *parent) : QObject(parent) {
+    // mostly waiting on the filesystem, more threads than cores is fine (and helps on nfs)
+    pool.setMaxThreadCount(qMax(4, QThread::idealThreadCount()));
+}
+
+DirectoryScanner::~DirectoryScanner() {
+    cancel();
+    pool.waitForDone();
+}
+
+void DirectoryScanner::start(const QString &path, const ScanOptions &options, std::function<void(EntryStore&)> sortBatch) {
+    cancel();
+    current = std::make_shared<ScanState>();
+    current->generation = ++generation;
+    current->options = options;
+    current->sortBatch = sortBatch;
+    enqueue(current, QDir(path).absolutePath());
+}
+
+void DirectoryScanner::cancel() {
+    if(!current)
+        return;
+    current->cancelled = true;
+    current.reset();
+}
+
+bool DirectoryScanner::isRunning() const {
+    return current != nullptr;
+}
+
+// thread safe
+void DirectoryScanner::enqueue(std::shared_ptr<ScanState> scan, const QString &dirPath) {
+    scan->pending++;
+    pool.start([this, scan, dirPath]() {
+        scanDirectory(scan, dirPath);
+    });
+}
+
+// worker thread
+void DirectoryScanner::scanDirectory(std::shared_ptr<ScanState> scan, const QString &dirPath) {
+    if(!scan->cancelled) {
+        auto flush = [this, &scan](EntryStore &entries) {
+            if(scan->cancelled)
+                return false;
+            auto batch = std::make_shared<EntryStore>();
+            batch->swap(entries);
+            scan->sortBatch(*batch);
+            submit(ScanBatch{ scan->generation, batch });
+            return true;
+        };
+        EntryStore entries;
+        QStringList subdirs;
+        readDirectory(dirPath, scan->options, entries, subdirs, flush);
+        // queue subdirectories before this task counts as done
+        if(!scan->cancelled) {
+            for(auto &subdir : subdirs)
+                enqueue(scan, subdir);
+        }
+        if(!entries.isEmpty())
+            flush(entries);
+    }
+    if(--scan->pending == 0 && !scan->cancelled)
+        submit(ScanBatch{ scan->generation, nullptr });
+}
+
+// worker thread
+void DirectoryScanner::submit(ScanBatch batch) {
+    if(results.push(std::move(batch)))
+        QMetaObject::invokeMethod(this, &DirectoryScanner::drain, Qt::QueuedConnection);
+}
+
+void DirectoryScanner::drain() {
+    for(auto &batch : results.takeAll()) {
+        // leftovers of a cancelled scan
+        if(!current || batch.generation != current->generation)
+            continue;
+        if(batch.entries) {
+            emit batchReady(batch.entries);
+        } else {
+            current.reset();
+            emit finished();
+        }
+    }
+}
+
+#ifdef Q_OS_LINUX
+static QString childPath(const QString &dirPath, const QString &name) {
+    // root dir already ends with a separator
+    if(dirPath.endsWith('/'))
+        return dirPath + name;
+    return dirPath + '/' + name;
+}
+
+// the kernel record filled by getdents64
+struct LinuxDirent64 {
+    ino64_t        d_ino;
+    off64_t        d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[];
+};
+
+// same as QFileInfo::suffix(), but on raw bytes
+static bool hasSupportedSuffix(const char *name, const QSet<QByteArray> &extensions) {
+    const char *dot = strrchr(name, '.');
+    if(!dot)
+        return extensions.contains(QByteArray());
+    return extensions.contains(QByteArray(dot + 1).toLower());
+}
+
+// size, mtime (msecs) and identity of a directory entry, follows symlinks
+static bool statEntry(int dirFd, const char *name, int64_t &size, int64_t &mtime, uint64_t &inode, uint64_t &device) {
+#ifdef STATX_BASIC_STATS
+    struct statx stx;
+    if(statx(dirFd, name, AT_NO_AUTOMOUNT, STATX_SIZE | STATX_MTIME | STATX_INO, &stx) != 0)
+        return false;
+    size = static_cast<int64_t>(stx.stx_size);
+    inode = stx.stx_ino;
+    device = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+    mtime = static_cast<int64_t>(stx.stx_mtime.tv_sec) * 1000 + stx.stx_mtime.tv_nsec / 1000000;
+#else
+    struct stat st;
+    if(fstatat(dirFd, name, &st, AT_NO_AUTOMOUNT) != 0)
+        return false;
+    size = st.st_size;
+    inode = st.st_ino;
+    device = st.st_dev;
+    mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+#endif
+    return true;
+}
+
+// Reads raw directory records in large chunks. d_type tells files from
+// directories for free on most filesystems; only symlinks and filesystems that
+// report DT_UNKNOWN need an extra stat.
+// Size and mtime of every listed entry are read here as well (one statx each,
+// relative to the open directory), so sorting by size or time never stats.
+bool DirectoryScanner::readDirectory(const QString &dirPath, const ScanOptions &options, EntryStore &entries,
+                                     QStringList &subdirs, const std::function<bool(EntryStore&)> &flush)
+{
+    int fd = open(QFile::encodeName(dirPath).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(fd < 0)
+        return false;
+    // regular entries live on the directory's filesystem, only followed symlinks may not
+    struct stat dirStat;
+    uint64_t dirDevice = (fstat(fd, &dirStat) == 0) ? dirStat.st_dev : 0;
+    std::vector<char> buffer(64 * 1024);
+    bool result = true;
+    long bytes;
+    while(result && (bytes = syscall(SYS_getdents64, fd, buffer.data(), buffer.size())) > 0) {
+        for(long offset = 0; offset < bytes;) {
+            auto dirent = reinterpret_cast<LinuxDirent64*>(buffer.data() + offset);
+            offset += dirent->d_reclen;
+            const char *name = dirent->d_name;
+            if(name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+                continue;
+            uint8_t flags = 0;
+            if(name[0] == '.') {
+                if(!options.hidden)
+                    continue;
+                flags |= ENTRY_HIDDEN;
+            }
+            unsigned char type = dirent->d_type;
+            int64_t size = -1, mtime = -1;
+            uint64_t inode = dirent->d_ino;
+            uint64_t device = dirDevice;
+            if(type == DT_LNK || type == DT_UNKNOWN) {
+                if(type == DT_LNK)
+                    flags |= ENTRY_SYMLINK;
+                struct stat st;
+                // follows symlinks; dangling ones are skipped
+                if(fstatat(fd, name, &st, 0) != 0)
+                    continue;
+                type = S_ISDIR(st.st_mode) ? DT_DIR : (S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN);
+                size = st.st_size;
+                mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+                inode = st.st_ino;
+                device = st.st_dev;
+            }
+            if(type == DT_DIR) {
+                if(options.recursive && !(flags & ENTRY_SYMLINK))
+                    subdirs.append(childPath(dirPath, QFile::decodeName(name)));
+                if(!options.directories)
+                    continue;
+                if(mtime < 0)
+                    statEntry(fd, name, size, mtime, inode, device);
+                entries.append(dirPath, QFile::decodeName(name), flags | ENTRY_DIR, size, mtime, inode, device);
+            } else if(type == DT_REG && !options.directories) {
+                if(!hasSupportedSuffix(name, options.extensions))
+                    continue;
+                // gone already? left unknown, read on demand
+                if(mtime < 0)
+                    statEntry(fd, name, size, mtime, inode, device);
+                entries.append(dirPath, QFile::decodeName(name), flags, size, mtime, inode, device);
+            } else {
+                continue;
+            }
+            if(flush && entries.count() >= SCAN_BATCH_SIZE && !flush(entries)) {
+                result = false;
+                break;
+            }
+        }
+    }
+    close(fd);
+    return result && bytes == 0;
+}
+#else
+bool DirectoryScanner::readDirectory(const QString &dirPath, const ScanOptions &options, EntryStore &entries,
+                                     QStringList &subdirs, const std::function<bool(EntryStore&)> &flush)
+{
+    QDir::Filters filters = QDir::NoDotAndDotDot | QDir::AllDirs;
+    if(!options.directories)
+        filters |= QDir::Files;
+    if(options.hidden)
+        filters |= QDir::Hidden;
+    QDirIterator iterator(dirPath, filters);
+    while(iterator.hasNext()) {
+        QFileInfo info = iterator.nextFileInfo();
+        uint8_t flags = 0;
+        if(info.isSymLink())
+            flags |= ENTRY_SYMLINK;
+        if(info.isHidden())
+            flags |= ENTRY_HIDDEN;
+        if(info.isDir()) {
+            if(options.recursive && !info.isSymLink())
+                subdirs.append(info.absoluteFilePath());
+            if(!options.directories)
+                continue;
+            entries.append(dirPath, info.fileName(), flags | ENTRY_DIR, info.size(), info.lastModified().toMSecsSinceEpoch());
+        } else {
+            if(!options.extensions.contains(info.suffix().toLower().toLatin1()))
+                continue;
+            // the iterator's stat data (free on Windows)
+            entries.append(dirPath, info.fileName(), flags, info.size(), info.lastModified().toMSecsSinceEpoch());
+        }
+        if(flush && entries.count() >= SCAN_BATCH_SIZE && !flush(entries))
+            return false;
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QObject>
+#include <QThreadPool>
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <QByteArray>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include "entrystore.h"
+#include "utils/mpscqueue.h"
+
+// entries per streamed batch
+#define SCAN_BATCH_SIZE 2048
+
+struct ScanOptions {
+    bool recursive = false;
+    // list directories instead of files
+    bool directories = false;
+    bool hidden = false;
+    // lowercase suffixes of supported files
+    QSet<QByteArray> extensions;
+};
+
+struct ScanState;
+
+struct ScanBatch {
+    int generation;
+    // nullptr marks the end of the scan
+    std::shared_ptr<EntryStore> entries;
+};
+
+// Background directory listing.
+// Every directory is read by its own pool task, so recursive scans run in
+// parallel across subdirectories. Entries come back in batches of up to
+// SCAN_BATCH_SIZE, each one sorted on the worker by `sortBatch`.
+// Results are delivered on the thread the scanner lives in.
+class DirectoryScanner : public QObject {
+    Q_OBJECT
+public:
+    explicit DirectoryScanner(QObject *parent = nullptr);
+    ~DirectoryScanner();
+
+    // cancels the previous scan, if any
+    void start(const QString &path, const ScanOptions &options, std::function<void(EntryStore&)> sortBatch);
+    // pending results of the cancelled scan are dropped
+    void cancel();
+    bool isRunning() const;
+
+    // Reads a single directory level. Every matching entry is stat()ed for its
+    // size, mtime and inode (statx() relative to the open directory on Linux).
+    // Matching entries are appended to `entries`; when `flush` is set it is
+    // handed every full batch and may return false to abort.
+    // Subdirectories to descend into (recursive mode, no symlinks) go to `subdirs`.
+    static bool readDirectory(const QString &dirPath, const ScanOptions &options, EntryStore &entries,
+                              QStringList &subdirs, const std::function<bool(EntryStore&)> &flush = nullptr);
+
+signals:
+    void batchReady(std::shared_ptr<EntryStore> entries);
+    void finished();
+
+private slots:
+    void drain();
+
+private:
+    void enqueue(std::shared_ptr<ScanState> scan, const QString &dirPath);
+    void scanDirectory(std::shared_ptr<ScanState> scan, const QString &dirPath);
+    void submit(ScanBatch batch);
+
+    QThreadPool pool;
+    MpscQueue<ScanBatch> results;
+    std::shared_ptr<ScanState> current;
+    int generation = 0;
+};
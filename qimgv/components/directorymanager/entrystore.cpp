@@ -0,0 +1,345 @@
+#include "entrystore.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/stat.h>
+#endif
+
+// QCollator setup is not cheap and instances must not be shared between threads,
+// so every thread (gui, scanner workers) reuses its own
+static QCollator &sortCollator() {
+    thread_local QCollator collator = [] {
+        QCollator numeric;
+        numeric.setNumericMode(true);
+        return numeric;
+    }();
+    return collator;
+}
+
+EntryStore::EntryStore() {
+}
+
+int EntryStore::count() const {
+    return static_cast<int>(names.size());
+}
+
+bool EntryStore::isEmpty() const {
+    return names.empty();
+}
+
+void EntryStore::clear() {
+    dirs.clear();
+    dirIds.clear();
+    dirKeys.clear();
+    names.clear();
+    nameKeys.clear();
+    nameMasks.clear();
+    parents.clear();
+    entryFlags.clear();
+    sizes.clear();
+    mtimes.clear();
+    inodes.clear();
+    devices.clear();
+    metas.clear();
+}
+
+void EntryStore::reserve(int size) {
+    names.reserve(size);
+    nameKeys.reserve(size);
+    nameMasks.reserve(size);
+    parents.reserve(size);
+    entryFlags.reserve(size);
+    sizes.reserve(size);
+    mtimes.reserve(size);
+    inodes.reserve(size);
+    devices.reserve(size);
+    metas.reserve(size);
+}
+
+int EntryStore::internDir(const QString &dirPath) {
+    auto it = dirIds.constFind(dirPath);
+    if(it != dirIds.constEnd())
+        return it.value();
+    dirs.append(dirPath);
+    dirIds.insert(dirPath, dirs.count() - 1);
+    dirKeys.push_back(sortCollator().sortKey(dirPath));
+    return dirs.count() - 1;
+}
+
+int EntryStore::append(const QString &dirPath, const QString &name, uint8_t flags, int64_t size, int64_t mtime, uint64_t inode, uint64_t device) {
+    parents.push_back(internDir(dirPath));
+    names.push_back(name);
+    nameKeys.push_back(sortCollator().sortKey(name));
+    nameMasks.push_back(charMask(name));
+    entryFlags.push_back(flags);
+    sizes.push_back(size);
+    mtimes.push_back(mtime);
+    inodes.push_back(inode);
+    devices.push_back(device);
+    metas.emplace_back();
+    return count() - 1;
+}
+
+int EntryStore::append(const QFileInfo &info) {
+    uint8_t flags = 0;
+    if(info.isDir())
+        flags |= ENTRY_DIR;
+    if(info.isSymLink())
+        flags |= ENTRY_SYMLINK;
+    if(info.isHidden())
+        flags |= ENTRY_HIDDEN;
+    return append(QDir::cleanPath(info.absolutePath()), info.fileName(), flags);
+}
+
+int EntryStore::appendFrom(const EntryStore &other, int index) {
+    const QString &dirPath = other.dirPath(index);
+    int dirId;
+    auto it = dirIds.constFind(dirPath);
+    if(it != dirIds.constEnd()) {
+        dirId = it.value();
+    } else {
+        dirs.append(dirPath);
+        dirId = dirs.count() - 1;
+        dirIds.insert(dirPath, dirId);
+        dirKeys.push_back(other.dirKeys[other.parents[index]]);
+    }
+    parents.push_back(dirId);
+    names.push_back(other.names[index]);
+    nameKeys.push_back(other.nameKeys[index]);
+    nameMasks.push_back(other.nameMasks[index]);
+    entryFlags.push_back(other.entryFlags[index]);
+    sizes.push_back(other.sizes[index]);
+    mtimes.push_back(other.mtimes[index]);
+    inodes.push_back(other.inodes[index]);
+    devices.push_back(other.devices[index]);
+    metas.push_back(other.metas[index]);
+    return count() - 1;
+}
+
+void EntryStore::swap(EntryStore &other) {
+    dirs.swap(other.dirs);
+    dirIds.swap(other.dirIds);
+    dirKeys.swap(other.dirKeys);
+    names.swap(other.names);
+    nameKeys.swap(other.nameKeys);
+    nameMasks.swap(other.nameMasks);
+    parents.swap(other.parents);
+    entryFlags.swap(other.entryFlags);
+    sizes.swap(other.sizes);
+    mtimes.swap(other.mtimes);
+    inodes.swap(other.inodes);
+    devices.swap(other.devices);
+    metas.swap(other.metas);
+}
+
+void EntryStore::remove(int index) {
+    names.erase(names.begin() + index);
+    nameKeys.erase(nameKeys.begin() + index);
+    nameMasks.erase(nameMasks.begin() + index);
+    parents.erase(parents.begin() + index);
+    entryFlags.erase(entryFlags.begin() + index);
+    sizes.erase(sizes.begin() + index);
+    mtimes.erase(mtimes.begin() + index);
+    inodes.erase(inodes.begin() + index);
+    devices.erase(devices.begin() + index);
+    metas.erase(metas.begin() + index);
+}
+
+template<typename T>
+static void moveElement(std::vector<T> &vec, int from, int to) {
+    if(from < to)
+        std::rotate(vec.begin() + from, vec.begin() + from + 1, vec.begin() + to + 1);
+    else
+        std::rotate(vec.begin() + to, vec.begin() + from, vec.begin() + from + 1);
+}
+
+void EntryStore::move(int from, int to) {
+    if(from == to)
+        return;
+    moveElement(names, from, to);
+    moveElement(nameKeys, from, to);
+    moveElement(nameMasks, from, to);
+    moveElement(parents, from, to);
+    moveElement(entryFlags, from, to);
+    moveElement(sizes, from, to);
+    moveElement(mtimes, from, to);
+    moveElement(inodes, from, to);
+    moveElement(devices, from, to);
+    moveElement(metas, from, to);
+}
+
+template<typename T>
+static void reorderColumn(std::vector<T> &vec, const std::vector<int> &newOrder) {
+    std::vector<T> result;
+    result.reserve(vec.size());
+    for(int oldIndex : newOrder)
+        result.push_back(std::move(vec[oldIndex]));
+    vec.swap(result);
+}
+
+void EntryStore::reorder(const std::vector<int> &newOrder) {
+    reorderColumn(names, newOrder);
+    reorderColumn(nameKeys, newOrder);
+    reorderColumn(nameMasks, newOrder);
+    reorderColumn(parents, newOrder);
+    reorderColumn(entryFlags, newOrder);
+    reorderColumn(sizes, newOrder);
+    reorderColumn(mtimes, newOrder);
+    reorderColumn(inodes, newOrder);
+    reorderColumn(devices, newOrder);
+    reorderColumn(metas, newOrder);
+}
+
+QString EntryStore::path(int index) const {
+    const QString &dir = dirs.at(parents[index]);
+    // root dir already ends with a separator
+    if(dir.endsWith('/'))
+        return dir + names[index];
+    return dir + '/' + names[index];
+}
+
+const QString &EntryStore::name(int index) const {
+    return names[index];
+}
+
+const QString &EntryStore::dirPath(int index) const {
+    return dirs.at(parents[index]);
+}
+
+int EntryStore::dirId(int index) const {
+    return parents[index];
+}
+
+uint8_t EntryStore::flags(int index) const {
+    return entryFlags[index];
+}
+
+bool EntryStore::isDir(int index) const {
+    return entryFlags[index] & ENTRY_DIR;
+}
+
+int64_t EntryStore::size(int index) const {
+    if(sizes[index] < 0)
+        stat(index);
+    return sizes[index];
+}
+
+int64_t EntryStore::mtime(int index) const {
+    if(mtimes[index] < 0)
+        stat(index);
+    return mtimes[index];
+}
+
+QDateTime EntryStore::lastModified(int index) const {
+    return QDateTime::fromMSecsSinceEpoch(mtime(index));
+}
+
+uint64_t EntryStore::inode(int index) const {
+    if(mtimes[index] < 0)
+        stat(index);
+    return inodes[index];
+}
+
+uint64_t EntryStore::device(int index) const {
+    if(mtimes[index] < 0)
+        stat(index);
+    return devices[index];
+}
+
+MetadataKey EntryStore::metadataKey(int index) const {
+    return MetadataIndex::fileKey(device(index), inode(index), path(index), mtime(index));
+}
+
+// marks entries that were looked up but are not indexed yet
+static const std::shared_ptr<const ImageMetadata> &notIndexed() {
+    static const std::shared_ptr<const ImageMetadata> unknown(new ImageMetadata());
+    return unknown;
+}
+
+void EntryStore::lookupMetadata(int index) const {
+    std::shared_ptr<const ImageMetadata> meta;
+    if(metadataIndex)
+        meta = metadataIndex->lookup(metadataKey(index));
+    metas[index] = meta ? meta : notIndexed();
+}
+
+const ImageMetadata &EntryStore::metadata(int index) const {
+    if(!metas[index])
+        lookupMetadata(index);
+    return *metas[index];
+}
+
+bool EntryStore::hasMetadata(int index) const {
+    if(!metas[index])
+        lookupMetadata(index);
+    return metas[index] != notIndexed();
+}
+
+uint64_t EntryStore::nameMask(int index) const {
+    return nameMasks[index];
+}
+
+// one bit per folded character (mod 64)
+uint64_t EntryStore::charMask(const QString &text) {
+    uint64_t mask = 0;
+    for(QChar c : text)
+        mask |= uint64_t(1) << (c.toCaseFolded().unicode() % 64);
+    return mask;
+}
+
+int EntryStore::compareNames(int index1, int index2) const {
+    return nameKeys[index1].compare(nameKeys[index2]);
+}
+
+int EntryStore::comparePaths(int index1, int index2) const {
+    if(parents[index1] != parents[index2]) {
+        int result = dirKeys[parents[index1]].compare(dirKeys[parents[index2]]);
+        if(result)
+            return result;
+    }
+    return nameKeys[index1].compare(nameKeys[index2]);
+}
+
+void EntryStore::refresh(int index) {
+    stat(index);
+    // different file version
+    metas[index].reset();
+}
+
+void EntryStore::statAll() const {
+    for(int i = 0; i < count(); i++) {
+        if(sizes[i] < 0 || mtimes[i] < 0)
+            stat(i);
+    }
+}
+
+void EntryStore::loadMetadata() const {
+    statAll();
+    for(int i = 0; i < count(); i++) {
+        if(!metas[i])
+            lookupMetadata(i);
+    }
+}
+
+void EntryStore::clearMetadata() {
+    for(auto &meta : metas)
+        meta.reset();
+}
+
+void EntryStore::stat(int index) const {
+#ifdef Q_OS_LINUX
+    struct stat st;
+    if(::stat(QFile::encodeName(path(index)).constData(), &st) != 0) {
+        sizes[index] = 0;
+        mtimes[index] = 0;
+        return;
+    }
+    sizes[index] = st.st_size;
+    mtimes[index] = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+    inodes[index] = st.st_ino;
+    devices[index] = st.st_dev;
+#else
+    QFileInfo info(path(index));
+    sizes[index] = info.exists() ? info.size() : 0;
+    mtimes[index] = info.exists() ? info.lastModified().toMSecsSinceEpoch() : 0;
+#endif
+}
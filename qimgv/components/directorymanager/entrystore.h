@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QDir>
+#include <QCollator>
+#include <QCollatorSortKey>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include "components/cache/metadataindex.h"
+
+enum EntryFlag : uint8_t {
+    ENTRY_DIR     = 0x1,
+    ENTRY_SYMLINK = 0x2,
+    ENTRY_HIDDEN  = 0x4
+};
+
+// Compact directory listing, one array per column (struct of arrays).
+// Parent directory paths are interned, each entry only keeps its name.
+// Collation keys (numeric mode) are computed once on append, so sorting never
+// runs the collator itself.
+// Size and mtime normally come with the listing (see DirectoryScanner);
+// when unknown (-1) they are read on first request, see stat()
+// Image metadata is looked up in the MetadataIndex on first request.
+// Each name also gets a bitmask of its (case folded) characters, so a name
+// filter can reject most entries without a string search, see NameFilter.
+class EntryStore {
+public:
+    EntryStore();
+
+    int count() const;
+    bool isEmpty() const;
+    void clear();
+    void reserve(int size);
+
+    // returns the new entry index (always the last one)
+    int append(const QString &dirPath, const QString &name, uint8_t flags, int64_t size = -1, int64_t mtime = -1, uint64_t inode = 0, uint64_t device = 0);
+    int append(const QFileInfo &info);
+    // copies entry `index` of another store, collation keys included
+    int appendFrom(const EntryStore &other, int index);
+    void swap(EntryStore &other);
+    void remove(int index);
+    // moves an entry, shifting everything in between
+    void move(int from, int to);
+    // newOrder[i] is the old index of the entry that goes to position i
+    void reorder(const std::vector<int> &newOrder);
+
+    QString path(int index) const;
+    const QString &name(int index) const;
+    const QString &dirPath(int index) const;
+    int dirId(int index) const;
+    uint8_t flags(int index) const;
+    bool isDir(int index) const;
+    // lazily stats the file if needed
+    int64_t size(int index) const;
+    // msecs since epoch
+    int64_t mtime(int index) const;
+    QDateTime lastModified(int index) const;
+    // 0 if unknown (or not available on this platform)
+    uint64_t inode(int index) const;
+    // st_dev of the inode above
+    uint64_t device(int index) const;
+    // indexed metadata, an empty record if not indexed yet
+    const ImageMetadata &metadata(int index) const;
+    bool hasMetadata(int index) const;
+    MetadataKey metadataKey(int index) const;
+    uint64_t nameMask(int index) const;
+    static uint64_t charMask(const QString &text);
+    // natural (numeric) order using the precomputed keys. Thread safe
+    int compareNames(int index1, int index2) const;
+    // parent directory first, then name
+    int comparePaths(int index1, int index2) const;
+    // re-read stat data of a changed file
+    void refresh(int index);
+    // fill in all unknown stat data (before sorting by size / time)
+    void statAll() const;
+    // look up all entries in the metadata index (before sorting by metadata)
+    void loadMetadata() const;
+    // drop looked up metadata, e.g. after the index got new entries
+    void clearMetadata();
+
+private:
+    void stat(int index) const;
+    void lookupMetadata(int index) const;
+    int internDir(const QString &dirPath);
+
+    // interned parent directories
+    QStringList dirs;
+    QHash<QString, int> dirIds;
+    std::vector<QCollatorSortKey> dirKeys;
+
+    std::vector<QString> names;
+    std::vector<QCollatorSortKey> nameKeys;
+    std::vector<uint64_t> nameMasks;
+    std::vector<int32_t> parents;
+    std::vector<uint8_t> entryFlags;
+    mutable std::vector<int64_t> sizes;
+    mutable std::vector<int64_t> mtimes;
+    mutable std::vector<uint64_t> inodes;
+    mutable std::vector<uint64_t> devices;
+    // nullptr: not looked up yet
+    mutable std::vector<std::shared_ptr<const ImageMetadata>> metas;
+};
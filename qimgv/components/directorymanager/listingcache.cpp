@@ -0,0 +1,108 @@
+#include "listingcache.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDir>
+#include <QLocale>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <sys/stat.h>
+#endif
+
+#define SNAPSHOT_MAGIC   0x514C5354 // "QLST"
+#define SNAPSHOT_VERSION 1
+// mtime granularity of some filesystems; a change within this window could go unnoticed
+#define SNAPSHOT_MIN_AGE_MS 2000
+
+qint64 ListingCache::directoryMtime(const QString &dirPath) {
+#ifdef Q_OS_LINUX
+    struct stat st;
+    if(stat(QFile::encodeName(dirPath).constData(), &st) != 0)
+        return -1;
+    return static_cast<qint64>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#else
+    QFileInfo info(dirPath);
+    if(!info.exists())
+        return -1;
+    return info.lastModified().toMSecsSinceEpoch() * 1000000;
+#endif
+}
+
+QByteArray ListingCache::optionsKey(const ScanOptions &options) {
+    QList<QByteArray> extensions(options.extensions.begin(), options.extensions.end());
+    std::sort(extensions.begin(), extensions.end());
+    QByteArray key = options.directories ? "d" : "f";
+    key += options.hidden ? "h:" : ":";
+    key += QLocale().name().toLatin1() + ":";
+    key += extensions.join(',');
+    return key;
+}
+
+QString ListingCache::snapshotPath(const QString &dirPath, const QByteArray &optionsKey) {
+    QByteArray id = dirPath.toUtf8() + '\0' + optionsKey;
+    return settings->tmpDir() + "listings/" + QCryptographicHash::hash(id, QCryptographicHash::Md5).toHex() + ".lst";
+}
+
+bool ListingCache::load(const QString &dirPath, const QByteArray &optionsKey, EntryStore &entries, SortingMode &sortingMode) {
+    QFile file(snapshotPath(dirPath, optionsKey));
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+    quint32 magic, version;
+    in >> magic >> version;
+    if(magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION)
+        return false;
+    QString savedPath;
+    QByteArray savedKey;
+    qint64 savedMtime;
+    qint32 savedMode, count;
+    in >> savedPath >> savedKey >> savedMtime >> savedMode >> count;
+    if(in.status() != QDataStream::Ok || savedPath != dirPath || savedKey != optionsKey || count < 0)
+        return false;
+    if(savedMtime != directoryMtime(dirPath)) {
+        file.remove();
+        return false;
+    }
+    entries.reserve(qMin(count, 1 << 20));
+    QString name;
+    quint8 flags;
+    for(int i = 0; i < count; i++) {
+        in >> name >> flags;
+        entries.append(dirPath, name, flags);
+    }
+    if(in.status() != QDataStream::Ok) {
+        qDebug() << "[ListingCache] corrupted snapshot for" << dirPath;
+        entries.clear();
+        file.remove();
+        return false;
+    }
+    sortingMode = static_cast<SortingMode>(savedMode);
+    return true;
+}
+
+// thread safe
+void ListingCache::save(const QString &dirPath, const QByteArray &optionsKey, qint64 dirMtime, const EntryStore &entries, SortingMode sortingMode) {
+    if(dirMtime < 0 || directoryMtime(dirPath) != dirMtime)
+        return;
+    if(QDateTime::currentMSecsSinceEpoch() - dirMtime / 1000000 < SNAPSHOT_MIN_AGE_MS)
+        return;
+    QString path = snapshotPath(dirPath, optionsKey);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly))
+        return;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << quint32(SNAPSHOT_MAGIC) << quint32(SNAPSHOT_VERSION);
+    out << dirPath << optionsKey << dirMtime << qint32(sortingMode) << qint32(entries.count());
+    // no stat data: editing a file in place does not touch the directory mtime
+    for(int i = 0; i < entries.count(); i++)
+        out << entries.name(i) << quint8(entries.flags(i));
+    file.commit();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include "settings.h"
+#include "entrystore.h"
+#include "directoryscanner.h"
+
+// file listings smaller than this are quicker to read again than to keep around
+#define LISTING_SNAPSHOT_MIN_FILES 500
+
+// On-disk snapshots of sorted, single-level directory listings.
+// A snapshot stays valid while the directory mtime and the listing options
+// (filters, locale) match, so revalidating it costs a single stat().
+class ListingCache {
+public:
+    // directory mtime in nanoseconds where available, -1 on error
+    static qint64 directoryMtime(const QString &dirPath);
+    static QByteArray optionsKey(const ScanOptions &options);
+    // fills `entries` in the saved order
+    static bool load(const QString &dirPath, const QByteArray &optionsKey, EntryStore &entries, SortingMode &sortingMode);
+    // `dirMtime` must be taken before the directory was read. Skipped when
+    // the directory changed since, or too recently for the mtime to be trusted
+    static void save(const QString &dirPath, const QByteArray &optionsKey, qint64 dirMtime, const EntryStore &entries, SortingMode sortingMode);
+
+private:
+    static QString snapshotPath(const QString &dirPath, const QByteArray &optionsKey);
+};
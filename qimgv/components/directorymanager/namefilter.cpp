@@ -0,0 +1,42 @@
+#include "namefilter.h"
+
+NameFilter::NameFilter(const QString &text) : mText(text.toCaseFolded()) {
+    mMask = EntryStore::charMask(mText);
+}
+
+bool NameFilter::isEmpty() const {
+    return mText.isEmpty();
+}
+
+const QString &NameFilter::text() const {
+    return mText;
+}
+
+bool NameFilter::matches(const EntryStore &entries, int index) const {
+    if((entries.nameMask(index) & mMask) != mMask)
+        return false;
+    return entries.name(index).contains(mText, Qt::CaseInsensitive);
+}
+
+void NameFilter::apply(const EntryStore &entries, std::vector<int> &result) const {
+    result.clear();
+    for(int i = 0; i < entries.count(); i++) {
+        if(matches(entries, i))
+            result.push_back(i);
+    }
+}
+
+void NameFilter::apply(const EntryStore &entries, const std::vector<int> &candidates, std::vector<int> &result) const {
+    std::vector<int> matching;
+    matching.reserve(candidates.size());
+    for(int i : candidates) {
+        if(matches(entries, i))
+            matching.push_back(i);
+    }
+    // `candidates` may be `result`
+    result.swap(matching);
+}
+
+bool NameFilter::narrows(const NameFilter &other) const {
+    return mText.contains(other.mText);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QString>
+#include <vector>
+#include "entrystore.h"
+
+// Case-insensitive substring match on entry names.
+// Results are entry positions in list order: a view over the store, not a copy.
+// The per-entry character masks reject most names without a string search,
+// and a query that extends the previous one only rescans its matches.
+class NameFilter {
+public:
+    explicit NameFilter(const QString &text = QString());
+
+    bool isEmpty() const;
+    // case folded
+    const QString &text() const;
+    bool matches(const EntryStore &entries, int index) const;
+    // all matches
+    void apply(const EntryStore &entries, std::vector<int> &result) const;
+    // matches among `candidates` (positions in ascending order)
+    void apply(const EntryStore &entries, const std::vector<int> &candidates, std::vector<int> &result) const;
+    // every name matching this filter also matches `other`
+    bool narrows(const NameFilter &other) const;
+
+private:
+    QString mText;
+    uint64_t mMask;
+};
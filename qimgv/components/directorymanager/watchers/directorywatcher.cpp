@@ -63,6 +63,16 @@ QString DirectoryWatcher::watchPath() const {
     return d->currentDirectory;
 }
 
+void DirectoryWatcher::setRecursive(bool recursive) {
+    Q_D(DirectoryWatcher);
+    d->recursive = recursive;
+}
+
+bool DirectoryWatcher::isRecursive() const {
+    Q_D(const DirectoryWatcher);
+    return d->recursive;
+}
+
 void DirectoryWatcher::observe()
 {
     Q_D(DirectoryWatcher);
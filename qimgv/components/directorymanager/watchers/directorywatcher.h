@@ -13,6 +13,11 @@ public:
 
     virtual void setWatchPath(const QString& watchPath);
     virtual QString watchPath() const;
+    // Watch the whole subtree. Event names are then relative to watchPath()
+    // and may contain subdirectories. Only LinuxWatcher supports this so far.
+    // Call before setWatchPath()
+    void setRecursive(bool recursive);
+    bool isRecursive() const;
     bool isObserving();
 
 public Q_SLOTS:
@@ -25,6 +30,9 @@ signals:
     void fileRenamed(const QString& old, const QString& now);
     void fileModified(const QString& filePath);
 
+    // not every subdirectory could be watched (system limit)
+    void watchLimitReached();
+
     void observingStarted();
     void observingStopped();
 
@@ -23,6 +23,7 @@ public:
     QScopedPointer<WatcherWorker> worker;
     QScopedPointer<QThread> workerThread;
     QString currentDirectory;
+    bool recursive = false;
 
 private:
     Q_DECLARE_PUBLIC(DirectoryWatcher)
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <sys/inotify.h>
+#include <atomic>
+
+#define EVENT_RING_CHUNKS       16
+// must fit at least one event with the longest name
+#define EVENT_RING_CHUNK_SIZE   (16 * 1024)
+
+// Fixed set of read buffers reused in a circle.
+// The worker thread read()s inotify data straight into the next free chunk,
+// the watcher parses chunks in order and hands them back. One producer,
+// one consumer, no allocations and no locks.
+class LinuxEventRing {
+public:
+    // producer. nullptr when every chunk is in use
+    char *writeBuffer() {
+        unsigned h = head.load(std::memory_order_relaxed);
+        if(h - tail.load(std::memory_order_acquire) == EVENT_RING_CHUNKS)
+            return nullptr;
+        return chunks[h % EVENT_RING_CHUNKS].data;
+    }
+
+    // producer. Returns true if the ring was empty (consumer needs a wakeup)
+    bool commit(unsigned size) {
+        unsigned h = head.load(std::memory_order_relaxed);
+        chunks[h % EVENT_RING_CHUNKS].size = size;
+        head.store(h + 1, std::memory_order_release);
+        return h == tail.load(std::memory_order_acquire);
+    }
+
+    // consumer. Oldest filled chunk, false if there is none
+    bool front(const char *&data, unsigned &size) const {
+        unsigned t = tail.load(std::memory_order_relaxed);
+        if(t == head.load(std::memory_order_acquire))
+            return false;
+        data = chunks[t % EVENT_RING_CHUNKS].data;
+        size = chunks[t % EVENT_RING_CHUNKS].size;
+        return true;
+    }
+
+    // consumer. Returns true if the ring was full (producer may be waiting)
+    bool release() {
+        unsigned t = tail.load(std::memory_order_relaxed);
+        bool wasFull = head.load(std::memory_order_acquire) - t == EVENT_RING_CHUNKS;
+        tail.store(t + 1, std::memory_order_release);
+        return wasFull;
+    }
+
+private:
+    struct Chunk {
+        alignas(inotify_event) char data[EVENT_RING_CHUNK_SIZE];
+        unsigned size;
+    };
+    Chunk chunks[EVENT_RING_CHUNKS];
+    std::atomic<unsigned> head{0};
+    std::atomic<unsigned> tail{0};
+};
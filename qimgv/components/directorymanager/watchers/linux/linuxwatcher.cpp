@@ -1,6 +1,11 @@
 #include <QTimer>
+#include <QFile>
 
 #include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "linuxwatcher_p.h"
 #include "linuxworker.h"
@@ -12,149 +17,332 @@
   * Time to wait for rename event. If event take time longer
   * than specified then event will be considered as remove event
   */
-
-// TODO: this may break event order.
-// Implement a proper queue.
 #define EVENT_MOVE_TIMEOUT      150 // ms
+// quiet time before a (repeating) modify event is reported
 #define EVENT_MODIFY_TIMEOUT    150 // ms
+// timer wheel resolution
+#define WHEEL_TICK              25  // ms
 
 LinuxWatcherPrivate::LinuxWatcherPrivate(LinuxWatcher* qq) :
     DirectoryWatcherPrivate(qq, new LinuxWorker()),
     watcher(-1),
-    watchObject(-1)
+    watchLimitReached(false),
+    wheel(WHEEL_SLOTS),
+    currentTick(0),
+    waitingCount(0)
 {
-    watcher = inotify_init();
-}
-
-int LinuxWatcherPrivate::indexOfWatcherEvent(uint cookie) const {
-    for (int i = 0; i < watcherEvents.size(); ++i) {
-        auto event = watcherEvents.at(i);
-        if (event->cookie() == cookie) {
-            return i;
-        }
-    }
-    return -1;
+    // non-blocking, the worker drains it until EAGAIN
+    watcher = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wheelTimer.setInterval(WHEEL_TICK);
+    connect(&wheelTimer, &QTimer::timeout, this, &LinuxWatcherPrivate::onWheelTick);
 }
 
-int LinuxWatcherPrivate::indexOfWatcherEvent(const QString& name) const {
-    for (int i = 0; i < watcherEvents.size(); ++i) {
-        auto event = watcherEvents.at(i);
-        if (event->name() == name) {
-            return i;
-        }
+// consumes every filled chunk of the ring, in order
+void LinuxWatcherPrivate::dispatchEvents() {
+    auto linuxWorker = static_cast<LinuxWorker*>(worker.data());
+    LinuxEventRing *ring = linuxWorker->ring();
+    const char *data;
+    unsigned size;
+    while (ring->front(data, size)) {
+        parseEvents(data, size);
+        if (ring->release())
+            linuxWorker->wake();
     }
-    return -1;
+    flushQueue();
 }
 
-void LinuxWatcherPrivate::dispatchFilesystemEvent(LinuxFsEvent* e) {
-    Q_Q(LinuxWatcher);
-
-    uint dataOffset = 0;
-    QScopedPointer<LinuxFsEvent> event(e);
-
-    while (dataOffset < event->dataSize()) {
-        inotify_event* notify_event = (inotify_event*) (event->data() + dataOffset);
+void LinuxWatcherPrivate::parseEvents(const char *data, unsigned size) {
+    unsigned dataOffset = 0;
+    while (dataOffset < size) {
+        const inotify_event* notify_event = reinterpret_cast<const inotify_event*>(data + dataOffset);
         dataOffset += sizeof(inotify_event) + notify_event->len;
 
         int mask        = notify_event->mask;
-        QString name    = notify_event->name;
         uint cookie     = notify_event->cookie;
         bool isDirEvent = mask & IN_ISDIR;
-        
-        // Skip events for directories and files that isn't in filter range
-        /*if((isDirEvent) && !(mask & IN_MOVED_TO) ) {
+
+        if (mask & IN_Q_OVERFLOW) {
+            qDebug() << TAG << "Event queue overflow, some changes were missed";
             continue;
-        }*/
+        }
+        auto dirIt = watchDirs.constFind(notify_event->wd);
+        // leftovers from a removed watch
+        if (dirIt == watchDirs.constEnd())
+            continue;
+        if (mask & IN_IGNORED) {
+            // watched directory is gone
+            dirWatches.remove(dirIt.value());
+            watchDirs.erase(dirIt);
+            continue;
+        }
+        // relative to the root
+        QString name = QFile::decodeName(notify_event->name);
+        if (!dirIt.value().isEmpty())
+            name = dirIt.value() + "/" + name;
 
         if (mask & IN_MODIFY) {
             handleModifyEvent(name);
         } else if (mask & IN_CREATE) {
+            // watch before anyone lists it, so nothing created inside is missed
+            if (isDirEvent && recursive)
+                addSubtreeWatches(name);
             handleCreateEvent(name);
         } else if (mask & IN_DELETE) {
+            if (isDirEvent && recursive)
+                removeSubtreeWatches(name, false);
             handleDeleteEvent(name);
         } else if (mask & IN_MOVED_FROM) {
             handleMovedFromEvent(name, cookie);
         } else if (mask & IN_MOVED_TO) {
+            if (isDirEvent && recursive && !pendingMoves.contains(cookie))
+                addSubtreeWatches(name);
             handleMovedToEvent(name, cookie);
         }
     }
 }
 
+// ---- ordered queue
+// Events are reported strictly in arrival order. Ones that wait (a move for
+// its pair, a modify for some quiet) hold back everything queued after them.
+
+std::shared_ptr<LinuxPendingEvent> LinuxWatcherPrivate::enqueue(LinuxPendingEvent::Type type, const QString &name) {
+    auto event = std::make_shared<LinuxPendingEvent>();
+    event->type = type;
+    event->name = name;
+    queue.push_back(event);
+    return event;
+}
+
+// ready after `timeout` ms, rounded up to whole ticks
+void LinuxWatcherPrivate::schedule(const std::shared_ptr<LinuxPendingEvent> &event, int timeout) {
+    int ticks = qBound(1, (timeout + WHEEL_TICK - 1) / WHEEL_TICK, WHEEL_SLOTS - 1);
+    event->readyAt = currentTick + ticks;
+    wheel[event->readyAt % WHEEL_SLOTS].push_back(event);
+    if (waitingCount++ == 0)
+        wheelTimer.start();
+}
+
+void LinuxWatcherPrivate::unschedule(const std::shared_ptr<LinuxPendingEvent> &event) {
+    // the wheel slot entry is skipped when it comes up
+    event->readyAt = 0;
+    if (--waitingCount == 0)
+        wheelTimer.stop();
+}
+
+// a modify that is still waiting for this name is of no use anymore
+void LinuxWatcherPrivate::dropPendingModify(const QString &name) {
+    auto it = pendingModifies.find(name);
+    if (it == pendingModifies.end())
+        return;
+    it.value()->cancelled = true;
+    unschedule(it.value());
+    pendingModifies.erase(it);
+}
+
 void LinuxWatcherPrivate::handleModifyEvent(const QString &name) {
-    // Find the same event in the list by file name
-    int eventIndex = indexOfWatcherEvent(name);
-    if (eventIndex == -1) {
-        // This is this first modify event for the current file
-        int timerId = startTimer(EVENT_MODIFY_TIMEOUT);
-        auto event = new WatcherEvent(name, timerId, WatcherEvent::Modify);
-        watcherEvents.append(QSharedPointer<WatcherEvent>(event));
-    } else {
-        auto event = watcherEvents.at(eventIndex);
-        // Restart timer again
-        killTimer(event->timerId());
-        int timerId = startTimer(EVENT_MODIFY_TIMEOUT);
-        event->setTimerId(timerId);
-    }
+    // Restart the quiet period: the report moves to the end of the queue
+    dropPendingModify(name);
+    auto event = enqueue(LinuxPendingEvent::Modified, name);
+    schedule(event, EVENT_MODIFY_TIMEOUT);
+    pendingModifies.insert(name, event);
 }
 
 void LinuxWatcherPrivate::handleDeleteEvent(const QString &name) {
-    Q_Q(LinuxWatcher);
-    emit q->fileDeleted(name);
+    dropPendingModify(name);
+    enqueue(LinuxPendingEvent::Deleted, name);
 }
 
 void LinuxWatcherPrivate::handleCreateEvent(const QString &name) {
-    Q_Q(LinuxWatcher);
-    emit q->fileCreated(name);
+    enqueue(LinuxPendingEvent::Created, name);
 }
 
 void LinuxWatcherPrivate::handleMovedFromEvent(const QString &name, uint cookie) {
-    int timerId = startTimer(EVENT_MOVE_TIMEOUT);
-    // Save timer id to find out later which event timer is running
-    auto event = new WatcherEvent(name, cookie, timerId, WatcherEvent::MovedFrom);
-    watcherEvents.append(QSharedPointer<WatcherEvent>(event));
+    dropPendingModify(name);
+    auto event = enqueue(LinuxPendingEvent::MovedFrom, name);
+    event->cookie = cookie;
+    schedule(event, EVENT_MOVE_TIMEOUT);
+    pendingMoves.insert(cookie, event);
 }
 
 void LinuxWatcherPrivate::handleMovedToEvent(const QString &name, uint cookie) {
-    Q_Q(LinuxWatcher);
-
     // Check if file waiting to be renamed
-    int eventIndex = indexOfWatcherEvent(cookie);
-    if (eventIndex == -1) {
+    auto it = pendingMoves.find(cookie);
+    if (it == pendingMoves.end()) {
         // No one event waiting for rename so this is a new file
-        emit q->fileCreated(name);
-    } else {
-        // Waiting for rename event is found
-        auto watcherEvent = watcherEvents.takeAt(eventIndex);
-        // Kill associated timer
-        killTimer(watcherEvent->timerId());
-        emit q->fileRenamed(watcherEvent->name(), name);
+        enqueue(LinuxPendingEvent::Created, name);
+        return;
     }
+    // Waiting for rename event is found; it is reported in its original place
+    auto event = it.value();
+    pendingMoves.erase(it);
+    unschedule(event);
+    if (recursive)
+        renameSubtreeWatches(event->name, name);
+    event->type = LinuxPendingEvent::Renamed;
+    event->newName = name;
 }
 
-void LinuxWatcherPrivate::timerEvent(QTimerEvent *timerEvent) {
+void LinuxWatcherPrivate::onWheelTick() {
+    currentTick++;
+    auto &slot = wheel[currentTick % WHEEL_SLOTS];
+    std::vector<std::shared_ptr<LinuxPendingEvent>> due;
+    due.swap(slot);
+    for (auto &event : due) {
+        // rescheduled, resolved or dropped meanwhile
+        if (event->readyAt != currentTick || event->cancelled)
+            continue;
+        unschedule(event);
+        if (event->type == LinuxPendingEvent::MovedFrom) {
+            // Rename event didn't happen so treat this event as remove event.
+            // A directory moved out of the tree is still watched by the kernel
+            pendingMoves.remove(event->cookie);
+            if (recursive)
+                removeSubtreeWatches(event->name, true);
+            event->type = LinuxPendingEvent::Deleted;
+        } else if (event->type == LinuxPendingEvent::Modified) {
+            pendingModifies.remove(event->name);
+        }
+    }
+    flushQueue();
+}
+
+void LinuxWatcherPrivate::flushQueue() {
     Q_Q(LinuxWatcher);
+    while (!queue.empty()) {
+        auto event = queue.front();
+        if (event->readyAt != 0 && !event->cancelled)
+            break;
+        queue.pop_front();
+        if (event->cancelled)
+            continue;
+        switch (event->type) {
+        case LinuxPendingEvent::Created:
+            emit q->fileCreated(event->name);
+            break;
+        case LinuxPendingEvent::Deleted:
+            emit q->fileDeleted(event->name);
+            break;
+        case LinuxPendingEvent::Modified:
+            emit q->fileModified(event->name);
+            break;
+        case LinuxPendingEvent::Renamed:
+            emit q->fileRenamed(event->name, event->newName);
+            break;
+        case LinuxPendingEvent::MovedFrom:
+            break;
+        }
+    }
+}
+
+void LinuxWatcherPrivate::clearQueue() {
+    queue.clear();
+    pendingMoves.clear();
+    pendingModifies.clear();
+    for (auto &slot : wheel)
+        slot.clear();
+    waitingCount = 0;
+    wheelTimer.stop();
+}
+
+QString LinuxWatcherPrivate::absolutePath(const QString &relativePath) const {
+    if (relativePath.isEmpty())
+        return currentDirectory;
+    return currentDirectory + "/" + relativePath;
+}
 
-    // Loop through waiting move events
-    int lastIndex = watcherEvents.size() - 1;
-    for (int i = lastIndex; i >= 0; --i) {
-        auto watcherEvent = watcherEvents.at(i);
-
-        if (watcherEvent->timerId() == timerEvent->timerId()) {
-            int type = watcherEvent->type();
-            if (type == WatcherEvent::MovedFrom) {
-                // Rename event didn't happen so treat this event as remove event
-                emit q->fileDeleted(watcherEvent->name());
-            } else if (type == WatcherEvent::Modify) {
-                emit q->fileModified(watcherEvent->name());
+bool LinuxWatcherPrivate::addWatch(const QString &relativePath) {
+    Q_Q(LinuxWatcher);
+    int wd = inotify_add_watch(watcher, QFile::encodeName(absolutePath(relativePath)).constData(), INOTIFY_EVENT_MASK);
+    if (wd == -1) {
+        if (errno == ENOSPC) {
+            if (!watchLimitReached) {
+                watchLimitReached = true;
+                qDebug() << TAG << "inotify watch limit reached after" << watchDirs.count()
+                         << "directories, raise fs.inotify.max_user_watches to watch the rest";
+                emit q->watchLimitReached();
             }
+        } else {
+            qDebug() << TAG << "Error:" << strerror(errno) << relativePath;
+        }
+        return false;
+    }
+    // same inode may come back under a new name
+    auto it = watchDirs.constFind(wd);
+    if (it != watchDirs.constEnd())
+        dirWatches.remove(it.value());
+    watchDirs.insert(wd, relativePath);
+    dirWatches.insert(relativePath, wd);
+    return true;
+}
 
-            watcherEvents.removeAt(i);
-            break;
+// Breadth first, so on hitting the watch limit it is the deepest levels that
+// go unwatched. Skips hidden directories and symlinks, like the listing does.
+void LinuxWatcherPrivate::addSubtreeWatches(const QString &relativePath) {
+    QStringList queue = { relativePath };
+    while (!queue.isEmpty() && !watchLimitReached) {
+        QString dirPath = queue.takeFirst();
+        if (!addWatch(dirPath))
+            continue;
+        DIR *dir = opendir(QFile::encodeName(absolutePath(dirPath)).constData());
+        if (!dir)
+            continue;
+        while (dirent *entry = readdir(dir)) {
+            if (entry->d_name[0] == '.')
+                continue;
+            bool isDir = entry->d_type == DT_DIR;
+            if (entry->d_type == DT_UNKNOWN) {
+                struct stat st;
+                isDir = fstatat(dirfd(dir), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+            }
+            if (isDir) {
+                QString name = QFile::decodeName(entry->d_name);
+                queue.append(dirPath.isEmpty() ? name : dirPath + "/" + name);
+            }
+        }
+        closedir(dir);
+    }
+}
+
+void LinuxWatcherPrivate::removeSubtreeWatches(const QString &relativePath, bool unwatch) {
+    QString prefix = relativePath + "/";
+    for (auto it = dirWatches.begin(); it != dirWatches.end();) {
+        if (it.key() == relativePath || it.key().startsWith(prefix)) {
+            if (unwatch)
+                inotify_rm_watch(watcher, it.value());
+            watchDirs.remove(it.value());
+            it = dirWatches.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // there may be room again
+    watchLimitReached = false;
+}
+
+void LinuxWatcherPrivate::renameSubtreeWatches(const QString &from, const QString &to) {
+    QString prefix = from + "/";
+    QHash<QString, int> renamed;
+    for (auto it = dirWatches.begin(); it != dirWatches.end();) {
+        if (it.key() == from || it.key().startsWith(prefix)) {
+            QString newPath = to + it.key().mid(from.length());
+            watchDirs.insert(it.value(), newPath);
+            renamed.insert(newPath, it.value());
+            it = dirWatches.erase(it);
+        } else {
+            ++it;
         }
     }
+    dirWatches.insert(renamed);
+}
 
-    // Stop timer anyway
-    killTimer(timerEvent->timerId());
+void LinuxWatcherPrivate::removeAllWatches() {
+    for (auto it = watchDirs.constBegin(); it != watchDirs.constEnd(); ++it) {
+        if (inotify_rm_watch(watcher, it.key()) == -1)
+            qDebug() << TAG << "Error:" << strerror(errno);
+    }
+    watchDirs.clear();
+    dirWatches.clear();
+    watchLimitReached = false;
 }
 
 LinuxWatcher::LinuxWatcher() : DirectoryWatcher(new LinuxWatcherPrivate(this)) {
@@ -166,8 +354,8 @@ LinuxWatcher::LinuxWatcher() : DirectoryWatcher(new LinuxWatcherPrivate(this)) {
     auto linuxWorker = static_cast<LinuxWorker*>(d->worker.data());
     linuxWorker->setDescriptor(d->watcher);
 
-    connect(linuxWorker, &LinuxWorker::fileEvent,
-            d, &LinuxWatcherPrivate::dispatchFilesystemEvent);
+    connect(linuxWorker, &LinuxWorker::eventsAvailable,
+            d, &LinuxWatcherPrivate::dispatchEvents, Qt::QueuedConnection);
 
     // Here's no need to destroy thread and worker. They're will be removed automatically
     connect(linuxWorker, &LinuxWorker::finished, d->workerThread.data(), &QThread::quit);
@@ -178,10 +366,8 @@ LinuxWatcher::LinuxWatcher() : DirectoryWatcher(new LinuxWatcherPrivate(this)) {
 
 LinuxWatcher::~LinuxWatcher() {
     Q_D(LinuxWatcher);
-    int removeStatusCode = inotify_rm_watch(d->watcher, d->watchObject);
-    if (removeStatusCode != 0) {
-        qDebug() << TAG << "Cannot remove inotify watcher instance:" << strerror(errno);
-    }
+    d->removeAllWatches();
+    close(d->watcher);
 }
 
 void LinuxWatcher::setWatchPath(const QString& path) {
@@ -189,16 +375,13 @@ void LinuxWatcher::setWatchPath(const QString& path) {
     DirectoryWatcher::setWatchPath(path);
 
     // Subscribe for specified filesystem events
-    if (d->watchObject != -1) {
-        int status = inotify_rm_watch(d->watcher, d->watchObject);
-        if (status == -1) {
-            qDebug() << TAG << "Error:" << strerror(errno);
-        }
-    }
-
-    // Add new path to be watched by inotify
-    d->watchObject = inotify_add_watch(d->watcher, path.toStdString().data(), INOTIFY_EVENT_MASK);
-    if (d->watchObject == -1) {
-        qDebug() << TAG << "Error:" << strerror(errno);
-    }
+    d->removeAllWatches();
+    // names in the queue are relative to the old path
+    d->clearQueue();
+
+    // Add new path (and its subdirectories) to be watched by inotify
+    if (d->recursive)
+        d->addSubtreeWatches("");
+    else
+        d->addWatch("");
 }
@@ -7,35 +7,78 @@
 #include <errno.h>
 #include <QDebug>
 #include <QTimer>
+#include <QHash>
+#include <deque>
+#include <memory>
+#include <vector>
 
-class LinuxFsEvent;
+// timer wheel size, covers the longest event timeout
+#define WHEEL_SLOTS 16
+
+// an event waiting in the ordered queue
+struct LinuxPendingEvent {
+    enum Type { Created, Deleted, Modified, MovedFrom, Renamed };
+    Type type = Created;
+    QString name;
+    QString newName;
+    uint cookie = 0;
+    // wheel tick this becomes ready at, 0 when ready
+    quint64 readyAt = 0;
+    // superseded, dropped without being reported
+    bool cancelled = false;
+};
 
 class LinuxWatcherPrivate : public DirectoryWatcherPrivate {
     Q_OBJECT
 public:
     explicit LinuxWatcherPrivate(LinuxWatcher* qq = 0);
 
-    int indexOfWatcherEvent(uint cookie) const;
-    int indexOfWatcherEvent(const QString& name) const;
-
     void handleModifyEvent(const QString& name);
     void handleDeleteEvent(const QString& name);
     void handleCreateEvent(const QString& name);
     void handleMovedFromEvent(const QString& name, uint cookie);
     void handleMovedToEvent(const QString& name, uint cookie);
+    void clearQueue();
 
-    int watcher;
-    int watchObject;
-
-    QVector<QSharedPointer<WatcherEvent>> watcherEvents;
+    // subtree watches (recursive mode), paths are relative to the watch root
+    bool addWatch(const QString& relativePath);
+    void addSubtreeWatches(const QString& relativePath);
+    void removeSubtreeWatches(const QString& relativePath, bool unwatch);
+    void renameSubtreeWatches(const QString& from, const QString& to);
+    void removeAllWatches();
+    QString absolutePath(const QString& relativePath) const;
 
-protected:
-    virtual void timerEvent(QTimerEvent* timerEvent) override;
+    int watcher;
+    // watch descriptor -> directory relative to the root ("" for the root itself)
+    QHash<int, QString> watchDirs;
+    QHash<QString, int> dirWatches;
+    bool watchLimitReached;
 
 private slots:
-    void dispatchFilesystemEvent(LinuxFsEvent *e);
+    void dispatchEvents();
+    void onWheelTick();
 
 private:
+    void parseEvents(const char *data, unsigned size);
+    std::shared_ptr<LinuxPendingEvent> enqueue(LinuxPendingEvent::Type type, const QString &name);
+    void schedule(const std::shared_ptr<LinuxPendingEvent> &event, int timeout);
+    void unschedule(const std::shared_ptr<LinuxPendingEvent> &event);
+    void dropPendingModify(const QString &name);
+    void flushQueue();
+
+    // events in arrival order, reported from the head once ready
+    std::deque<std::shared_ptr<LinuxPendingEvent>> queue;
+    // moved_from events waiting for their moved_to, by cookie
+    QHash<uint, std::shared_ptr<LinuxPendingEvent>> pendingMoves;
+    // modify events waiting for a quiet period, by name
+    QHash<QString, std::shared_ptr<LinuxPendingEvent>> pendingModifies;
+
+    // one timer for all waiting events
+    QTimer wheelTimer;
+    std::vector<std::vector<std::shared_ptr<LinuxPendingEvent>>> wheel;
+    quint64 currentTick;
+    int waitingCount;
+
     Q_DECLARE_PUBLIC(LinuxWatcher)
 };
 
@@ -1,6 +1,14 @@
-#include <sys/poll.h>
-#include <sys/ioctl.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#else
+#include <poll.h>
+#endif
 
 #include <QThread>
 #include <QDebug>
@@ -8,17 +16,62 @@
 #include "linuxworker.h"
 
 #define TAG         "[LinuxWatcherWorker]"
-#define TIMEOUT     300 // ms
 
 LinuxWorker::LinuxWorker() :
-    fd(-1)
+    fd(-1),
+    pollFd(-1)
 {
+#ifdef __linux__
+    wakeFds[0] = wakeFds[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+    if (pipe(wakeFds) == 0) {
+        fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
+        fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+    } else {
+        wakeFds[0] = wakeFds[1] = -1;
+    }
+#endif
+}
+
+LinuxWorker::~LinuxWorker() {
+    if (wakeFds[0] != -1)
+        close(wakeFds[0]);
+    if (wakeFds[1] != wakeFds[0] && wakeFds[1] != -1)
+        close(wakeFds[1]);
 }
 
+// expects a non-blocking descriptor
 void LinuxWorker::setDescriptor(int desc) {
     fd = desc;
 }
 
+LinuxEventRing *LinuxWorker::ring() {
+    return &mRing;
+}
+
+void LinuxWorker::wake() {
+    uint64_t value = 1;
+    if (write(wakeFds[1], &value, sizeof(value)) == -1 && errno != EAGAIN)
+        qDebug() << TAG << strerror(errno);
+}
+
+void LinuxWorker::stopped() {
+    wake();
+}
+
+// while the ring is full the (level triggered) inotify descriptor is taken
+// out of the wait set, otherwise the loop would spin
+void LinuxWorker::setInotifyArmed(bool armed) {
+#ifdef __linux__
+    epoll_event event = {};
+    event.events = armed ? EPOLLIN : 0;
+    event.data.fd = fd;
+    handleErrorCode(epoll_ctl(pollFd, EPOLL_CTL_MOD, fd, &event));
+#else
+    Q_UNUSED(armed)
+#endif
+}
+
 void LinuxWorker::run() {
     emit started();
 #if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
@@ -27,38 +80,66 @@ void LinuxWorker::run() {
     isRunning.storeRelaxed(true);
 #endif
 
-    if (fd == -1) {
+    if (fd == -1 || wakeFds[0] == -1) {
         qDebug() << TAG << "File descriptor isn't set! Stopping";
         emit finished();
         return;
     }
 
-    while (isRunning) {
-        int errorCode = 0;
-        uint bytesAvailable = 0;
-
-        // File descriptor event struct for polling service
-        pollfd pollDescriptor = { fd, POLLIN, 0 };
-
-        // Freeze thread till next event
-        errorCode = poll(&pollDescriptor, 1, TIMEOUT);
-        handleErrorCode(errorCode);
-
-        // Check how many bytes available
-        errorCode = ioctl(fd, FIONREAD, &bytesAvailable);
-        handleErrorCode(errorCode);
+#ifdef __linux__
+    pollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = wakeFds[0];
+    handleErrorCode(epoll_ctl(pollFd, EPOLL_CTL_ADD, wakeFds[0], &event));
+    event.data.fd = fd;
+    handleErrorCode(epoll_ctl(pollFd, EPOLL_CTL_ADD, fd, &event));
+#endif
+    bool armed = true;
 
-        if (bytesAvailable == 0) {
-            continue;
+    while (isRunning) {
+        // Freeze thread till next event or wakeup, no timeout
+#ifdef __linux__
+        epoll_event events[2];
+        int errorCode = epoll_wait(pollFd, events, 2, -1);
+#else
+        pollfd descriptors[2] = { { wakeFds[0], POLLIN, 0 }, { fd, static_cast<short>(armed ? POLLIN : 0), 0 } };
+        int errorCode = poll(descriptors, 2, -1);
+#endif
+        if (errorCode == -1) {
+            if (errno == EINTR)
+                continue;
+            handleErrorCode(errorCode);
+            break;
+        }
+        // reset the wakeup counter
+        uint64_t value;
+        while (read(wakeFds[0], &value, sizeof(value)) > 0);
+        if (!isRunning)
+            break;
+
+        // Move everything available into the ring
+        while (char *buffer = mRing.writeBuffer()) {
+            ssize_t bytes = read(fd, buffer, EVENT_RING_CHUNK_SIZE);
+            if (bytes <= 0) {
+                if (bytes == -1 && errno != EAGAIN)
+                    handleErrorCode(-1);
+                break;
+            }
+            if (mRing.commit(bytes))
+                emit eventsAvailable();
+        }
+        bool full = mRing.writeBuffer() == nullptr;
+        if (full == armed) {
+            armed = !full;
+            setInotifyArmed(armed);
         }
-
-        char* eventData = new char[bytesAvailable];
-        errorCode = read(fd, eventData, bytesAvailable);
-        handleErrorCode(errorCode);
-
-        emit fileEvent(new LinuxFsEvent(eventData, bytesAvailable));
     }
 
+#ifdef __linux__
+    close(pollFd);
+    pollFd = -1;
+#endif
     emit finished();
 }
 
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "linuxfsevent.h"
+#include "linuxeventring.h"
 #include "../watcherworker.h"
 
 class LinuxWorker : public WatcherWorker
@@ -8,15 +8,29 @@ class LinuxWorker : public WatcherWorker
     Q_OBJECT
 public:
     LinuxWorker();
+    ~LinuxWorker();
 
     void setDescriptor(int desc);
     void handleErrorCode(int code);
+    LinuxEventRing *ring();
+    // thread safe. Interrupts the wait, e.g. to stop or after the ring had been full
+    void wake();
 
     virtual void run() override;
 
 signals:
-    void fileEvent(LinuxFsEvent* event);
+    // the ring got its first chunk
+    void eventsAvailable();
+
+protected:
+    virtual void stopped() override;
 
 private:
+    void setInotifyArmed(bool armed);
+
     int fd;
+    // epoll + eventfd on linux, poll + pipe elsewhere
+    int pollFd;
+    int wakeFds[2];
+    LinuxEventRing mRing;
 };
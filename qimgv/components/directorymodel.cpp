@@ -7,15 +7,22 @@ DirectoryModel::DirectoryModel(QObject *parent) : QObject(parent)
     connect(&dirManager, &DirectoryManager::fileRemoved,  this, &DirectoryModel::onFileRemoved);
     connect(&dirManager, &DirectoryManager::fileAdded,    this, &DirectoryModel::onFileAdded);
     connect(&dirManager, &DirectoryManager::fileRenamed,  this, &DirectoryModel::onFileRenamed);
+    connect(&dirManager, &DirectoryManager::filesChanged, this, &DirectoryModel::onFilesChanged);
     connect(&dirManager, &DirectoryManager::fileModified, this, &DirectoryModel::onFileModified);
     connect(&dirManager, &DirectoryManager::dirRemoved,  this, &DirectoryModel::dirRemoved);
     connect(&dirManager, &DirectoryManager::dirAdded,    this, &DirectoryModel::dirAdded);
     connect(&dirManager, &DirectoryManager::dirRenamed,  this, &DirectoryModel::dirRenamed);
 
     connect(&dirManager, &DirectoryManager::loaded, this, &DirectoryModel::loaded);
+    connect(&dirManager, &DirectoryManager::filesInserted, this, &DirectoryModel::filesInserted);
+    connect(&dirManager, &DirectoryManager::errorOccurred, this, &DirectoryModel::errorOccurred);
+    connect(&dirManager, &DirectoryManager::scanFinished, this, &DirectoryModel::scanFinished);
     connect(&dirManager, &DirectoryManager::sortingChanged, this, &DirectoryModel::onSortingChanged);
+    connect(&dirManager, &DirectoryManager::orderChanged, this, &DirectoryModel::orderChanged);
     connect(&loader, &Loader::loadFinished, this, &DirectoryModel::onImageReady);
-    connect(&loader, &Loader::loadFailed, this, &DirectoryModel::loadFailed);
+    connect(&loader, &Loader::loadFailed, this, &DirectoryModel::onLoadFailed);
+    if(metadataIndex)
+        metadataIndex->setIndexOnRead(dirManager.isMetadataSorting());
 }
 
 DirectoryModel::~DirectoryModel() {
@@ -27,6 +34,14 @@ int DirectoryModel::totalCount() const {
     return dirManager.totalCount();
 }
 
+const EntryStore &DirectoryModel::files() const {
+    return dirManager.files();
+}
+
+const EntryStore &DirectoryModel::dirs() const {
+    return dirManager.dirs();
+}
+
 int DirectoryModel::fileCount() const {
     return dirManager.fileCount();
 }
@@ -47,9 +62,16 @@ SortingMode DirectoryModel::sortingMode() const {
     return dirManager.sortingMode();
 }
 
-const QFileInfo &DirectoryModel::fileInfoAt(int index) const
-{
-	return dirManager.fileEntryAt(index);
+QString DirectoryModel::filePathAt(int index) const {
+    return dirManager.filePathAt(index);
+}
+
+qint64 DirectoryModel::fileSizeAt(int index) const {
+    return dirManager.fileSizeAt(index);
+}
+
+QString DirectoryModel::dirPathAt(int index) const {
+    return dirManager.dirPathAt(index);
 }
 
 bool DirectoryModel::autoRefresh() {
@@ -104,6 +126,9 @@ bool DirectoryModel::forceInsert(QString filePath) {
 
 void DirectoryModel::setSortingMode(SortingMode mode) {
     dirManager.setSortingMode(mode);
+    // thumbnailers feed the index only when it is needed
+    if(metadataIndex)
+        metadataIndex->setIndexOnRead(dirManager.isMetadataSorting());
 }
 
 void DirectoryModel::removeFile(const QString &filePath, bool trash, FileOpResult &result) {
@@ -152,27 +177,35 @@ void DirectoryModel::moveFileTo(const QString &srcFile, const QString &destDirPa
     }
 }
 // -----------------------------------------------------------------------------
-bool DirectoryModel::setDirectory(const QString &path)
+bool DirectoryModel::setDirectory(const QString &path, bool async)
 {
 	cache.clear();
+	if (async) {
+		return dirManager.setDirectoryAsync(path);
+	}
 	return dirManager.setDirectory(path);
 }
 
+bool DirectoryModel::isScanning() const
+{
+	return dirManager.isScanning();
+}
+
 void DirectoryModel::unload(int index)
 {
-	cache.remove(this->fileInfoAt(index).absoluteFilePath());
+	cache.remove(this->filePathAt(index));
 }
 
 void DirectoryModel::unload(QString filePath) {
     cache.remove(filePath);
 }
 
-void DirectoryModel::unloadExcept(QString filePath, bool keepNearby) {
+void DirectoryModel::unloadExcept(QString filePath, QList<int> keep) {
     QList<QString> list;
     list << filePath;
-    if(keepNearby)  {
-        list << prevOf(filePath);
-        list << nextOf(filePath);
+    for(auto index : keep) {
+        if(dirManager.fileSizeAt(index))
+            list << dirManager.filePathAt(index);
     }
     cache.trimTo(list);
 }
@@ -183,14 +216,20 @@ bool DirectoryModel::loaderBusy() const {
 
 void DirectoryModel::onImageReady(std::shared_ptr<Image> img, const QString &path) {
     if(!img) {
-        emit loadFailed(path);
+        onLoadFailed(path);
         return;
     }
     cache.remove(path);
     cache.insert(img);
+    finishRequests(path, img);
     emit imageReady(img, path);
 }
 
+void DirectoryModel::onLoadFailed(const QString &path) {
+    finishRequests(path, nullptr);
+    emit loadFailed(path);
+}
+
 bool DirectoryModel::saveFile(const QString &filePath) {
     return saveFile(filePath, filePath);
 }
@@ -246,31 +285,51 @@ void DirectoryModel::onFileRemoved(QString filePath, int index) {
     emit fileRemoved(filePath, index);
 }
 
+void DirectoryModel::onFilesChanged(QStringList removedPaths, QList<int> removedAt, int previousCount) {
+    for(auto &path : removedPaths)
+        unload(path);
+    emit filesChanged(removedPaths, removedAt, previousCount);
+}
+
 void DirectoryModel::onFileRenamed(QString fromPath, int indexFrom, QString toPath, int indexTo) {
     unload(fromPath);
     emit fileRenamed(fromPath, indexFrom, toPath, indexTo);
 }
 
 bool DirectoryModel::isLoaded(int index) const {
-    return cache.contains(fileInfoAt(index).absoluteFilePath());
+    return cache.contains(filePathAt(index));
 }
 
 bool DirectoryModel::isLoaded(QString filePath) const {
     return cache.contains(filePath);
 }
 
-std::shared_ptr<Image> DirectoryModel::getImageAt(int index) {
-    return getImage(fileInfoAt(index).absoluteFilePath());
+std::shared_ptr<Image> DirectoryModel::cachedImage(QString filePath) {
+    return cache.get(filePath);
 }
 
-// returns cached image
-// if image is not cached, loads it in the main thread
-// for async access use loadAsync(), then catch onImageReady()
-std::shared_ptr<Image> DirectoryModel::getImage(QString filePath) {
+void DirectoryModel::requestImage(QString filePath, QObject *context, std::function<void(std::shared_ptr<Image>)> callback) {
     std::shared_ptr<Image> img = cache.get(filePath);
-    if(!img)
-        img = loader.load(filePath);
-    return img;
+    if(img || filePath.isEmpty()) {
+        callback(img);
+        return;
+    }
+    imageRequests[filePath].append({ context, callback });
+    loader.loadAsync(filePath);
+}
+
+void DirectoryModel::finishRequests(const QString &path, std::shared_ptr<Image> img) {
+    auto requests = imageRequests.take(path);
+    for(auto &req : requests) {
+        if(req.context)
+            req.callback(img);
+    }
+}
+
+// loadAsyncPriority() drops the queued tasks, put back the ones someone waits for
+void DirectoryModel::resumeRequests() {
+    for(auto &path : imageRequests.keys())
+        loader.loadAsync(path);
 }
 
 void DirectoryModel::updateImage(QString filePath, std::shared_ptr<Image> img) {
@@ -290,6 +349,7 @@ void DirectoryModel::load(QString filePath, bool asyncHint) {
     if(!cache.contains(filePath)) {
         if(asyncHint) {
             loader.loadAsyncPriority(filePath);
+            resumeRequests();
         } else {
             auto img = loader.load(filePath);
             if(img) {
@@ -308,17 +368,16 @@ void DirectoryModel::reload(QString filePath) {
     if(cache.contains(filePath)) {
         cache.remove(filePath);
         dirManager.updateFileEntry(filePath);
-        load(filePath, false);
+        load(filePath, true);
     }
 }
 
 void DirectoryModel::load(int index, bool async)
 {
-	QFileInfo info = dirManager.fileEntryAt(index);
-	if (info.size() == 0) {
+	if (dirManager.fileSizeAt(index) == 0) {
 		return;
 	}
-	QString file_path = info.absoluteFilePath();
+	QString file_path = dirManager.filePathAt(index);
 	if (loader.isLoading(file_path)) {
 		return;
 	}
@@ -331,6 +390,7 @@ void DirectoryModel::load(int index, bool async)
 
 	if (async) {
 		loader.loadAsyncPriority(file_path);
+		resumeRequests();
 		return;
 	}
 
@@ -345,9 +405,8 @@ void DirectoryModel::load(int index, bool async)
 
 void DirectoryModel::preload(int index)
 {
-	QFileInfo info = dirManager.fileEntryAt(index);
-	if (info.size()) {
-		QString file_path = info.absoluteFilePath();
+	if (dirManager.fileSizeAt(index)) {
+		QString file_path = dirManager.filePathAt(index);
 		if (cache.contains(file_path) == false) {
 			loader.loadAsync(file_path);
 		}
@@ -356,12 +415,11 @@ void DirectoryModel::preload(int index)
 
 void DirectoryModel::reload(int index)
 {
-	QFileInfo info = dirManager.fileEntryAt(index);
-	if (info.size()) {
-		QString file_path = info.absoluteFilePath();
+	if (dirManager.fileSizeAt(index)) {
+		QString file_path = dirManager.filePathAt(index);
 		if (cache.remove(file_path)) {
 			dirManager.updateFileEntry(file_path);
-			load(index, false);
+			load(index, true);
 		}
 	}
 }
@@ -376,7 +434,9 @@ void DirectoryModel::removeDirEntry(const QString &dirPath)
 	dirManager.removeDirEntry(dirPath);
 }
 
-QString DirectoryModel::resolveNextDirectory() const
+// sibling folders in the parent's (directories mode) listing.
+// Parent listings are served from snapshots while the parent is unchanged
+QString DirectoryModel::resolveAdjacentDirectory(bool next) const
 {
 	QString directory_path = this->directoryPath();
 
@@ -392,7 +452,17 @@ QString DirectoryModel::resolveNextDirectory() const
 		return QString();
 	}
 
-	return dm.nextOfDir(directory_path);
+	return next ? dm.nextOfDir(directory_path) : dm.prevOfDir(directory_path);
+}
+
+QString DirectoryModel::resolveNextDirectory() const
+{
+	return resolveAdjacentDirectory(true);
+}
+
+QString DirectoryModel::resolvePrevDirectory() const
+{
+	return resolveAdjacentDirectory(false);
 }
 
 void DirectoryModel::clear()
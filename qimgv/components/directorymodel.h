@@ -1,6 +1,8 @@
 #pragma once
 
 #include <QObject>
+#include <QPointer>
+#include <functional>
 #include "cache/cache.h"
 #include "directorymanager/directorymanager.h"
 #include "scaler/scaler.h"
@@ -39,6 +41,7 @@ public:
 	void removeFileEntry(const QString &filePath);
 	void removeDirEntry(const QString &dirPath);
 	QString resolveNextDirectory() const;
+	QString resolvePrevDirectory() const;
 
     bool forceInsert(QString filePath);
     void moveFileTo(const QString &srcFile, const QString &destDirPath, bool force, FileOpResult &result);
@@ -46,14 +49,20 @@ public:
     void removeFile(const QString &filePath, bool trash, FileOpResult &result);
     void removeDir(const QString &dirPath, bool trash, bool recursive, FileOpResult &result);
 
-  bool setDirectory(const QString &path);
+  // async: list the directory in the background, see DirectoryManager::setDirectoryAsync()
+  bool setDirectory(const QString &path, bool async = false);
+  bool isScanning() const;
 
     void unload(int index);
 
     bool loaderBusy() const;
 
-    std::shared_ptr<Image> getImageAt(int index);
-    std::shared_ptr<Image> getImage(QString filePath);
+    // returns the cached image or nullptr, never decodes
+    std::shared_ptr<Image> cachedImage(QString filePath);
+    // calls `callback` with the image once it is available (nullptr if it failed to load).
+    // cached images are delivered right away, the rest is loaded in the background.
+    // dropped if `context` is destroyed before that
+    void requestImage(QString filePath, QObject *context, std::function<void(std::shared_ptr<Image>)> callback);
 
     void updateImage(QString filePath, std::shared_ptr<Image> img);
 
@@ -66,10 +75,16 @@ public:
     bool isLoaded(QString filePath) const;
     void reload(QString filePath);
 
-    void unloadExcept(QString filePath, bool keepNearby);
-    const QFileInfo &fileInfoAt(int index) const;
+    // keeps `filePath` and the files at `keep` indexes
+    void unloadExcept(QString filePath, QList<int> keep);
+    QString filePathAt(int index) const;
+    qint64 fileSizeAt(int index) const;
+    QString dirPathAt(int index) const;
 
     int totalCount() const;
+    // raw listings, e.g. for filtering
+    const EntryStore &files() const;
+    const EntryStore &dirs() const;
 
     bool autoRefresh();
 
@@ -82,27 +97,46 @@ signals:
     void fileRemoved(QString filePath, int index);
     void fileRenamed(QString fromPath, int indexFrom, QString toPath, int indexTo);
     void fileAdded(QString filePath);
+    void filesChanged(QStringList removedPaths, QList<int> removedAt, int previousCount);
+    // scanned files merged into the list, see DirectoryManager::filesInserted()
+    void filesInserted(QList<int> indexes);
     void fileModified(QString filePath);
     void dirRemoved(QString dirPath, int index);
     void dirRenamed(QString dirPath, int indexFrom, QString toPath, int indexTo);
     void dirAdded(QString dirPath);
     void loaded(QString filePath);
+    void scanFinished(QString filePath);
     void loadFailed(const QString &path);
+    // listing / watcher problems worth telling the user about
+    void errorOccurred(const QString &message);
     void sortingChanged(SortingMode);
+    void orderChanged();
     void indexChanged(int oldIndex, int index);
     void imageReady(std::shared_ptr<Image> img, const QString&);
     void imageUpdated(QString filePath);
 
 private:
+    struct ImageRequest {
+        QPointer<QObject> context;
+        std::function<void(std::shared_ptr<Image>)> callback;
+    };
+
+    QString resolveAdjacentDirectory(bool next) const;
+    void finishRequests(const QString &path, std::shared_ptr<Image> img);
+    void resumeRequests();
+
     DirectoryManager dirManager;
     Loader loader;
     Cache cache;
+    QHash<QString, QList<ImageRequest>> imageRequests;
 
 private slots:
     void onImageReady(std::shared_ptr<Image> img, const QString &path);
+    void onLoadFailed(const QString &path);
     void onSortingChanged();
     void onFileAdded(QString filePath);
     void onFileRemoved(QString filePath, int index);
+    void onFilesChanged(QStringList removedPaths, QList<int> removedAt, int previousCount);
     void onFileRenamed(QString fromPath, int indexFrom, QString toPath, int indexTo);
     void onFileModified(QString filePath);
 };
@@ -21,7 +21,7 @@ void DirectoryPresenter::setView(std::shared_ptr<IDirectoryView> _view) {
         return;
     view = _view;
     if(model)
-        view->populate(mShowDirs ? model->totalCount() : model->fileCount());
+        view->populate(viewCount());
     connect(dynamic_cast<QObject *>(view.get()), SIGNAL(itemActivated(int)),
             this, SLOT(onItemActivated(int)));
     connect(dynamic_cast<QObject *>(view.get()), SIGNAL(thumbnailsRequested(QList<int>, int, bool, bool)),
@@ -59,7 +59,11 @@ void DirectoryPresenter::reloadModel() {
 void DirectoryPresenter::populateView() {
     if(!model || !view)
         return;
-    view->populate(mShowDirs ? model->totalCount() : model->fileCount());
+    updateFilter();
+    // indexes are about to change, queued requests are no longer valid
+    thumbnailer.clearTasks();
+    generation++;
+    view->populate(viewCount());
     selectAndFocus(0);
 }
 
@@ -69,10 +73,126 @@ void DirectoryPresenter::disconnectView() {
 
 //------------------------------------------------------------------------------
 
+bool DirectoryPresenter::isFiltered() const {
+    return !filter.isEmpty();
+}
+
+void DirectoryPresenter::setFilter(const QString &text) {
+    NameFilter newFilter(text);
+    if(newFilter.text() == filter.text() || !model)
+        return;
+    QList<QString> oldSelection = selectedPaths();
+    // a longer query only needs to look at what is shown now
+    bool narrowing = isFiltered() && newFilter.narrows(filter) && filterDirectory == model->directoryPath();
+    filter = newFilter;
+    filterDirectory = model->directoryPath();
+    if(narrowing) {
+        if(mShowDirs)
+            filter.apply(model->dirs(), filteredDirs, filteredDirs);
+        filter.apply(model->files(), filteredFiles, filteredFiles);
+    } else {
+        updateFilter();
+    }
+    if(!view)
+        return;
+    thumbnailer.clearTasks();
+    generation++;
+    view->populate(viewCount());
+    if(!oldSelection.isEmpty() && (model->containsFile(oldSelection.last()) || model->containsDir(oldSelection.last())))
+        selectAndFocus(oldSelection.last());
+    if(view->selection().isEmpty())
+        selectAndFocus(0);
+}
+
+// recomputes the visible entries from scratch
+void DirectoryPresenter::updateFilter() {
+    filteredDirs.clear();
+    filteredFiles.clear();
+    if(!model || !isFiltered())
+        return;
+    // a filter belongs to the directory it was typed in
+    if(filterDirectory != model->directoryPath()) {
+        filter = NameFilter();
+        return;
+    }
+    if(mShowDirs)
+        filter.apply(model->dirs(), filteredDirs);
+    filter.apply(model->files(), filteredFiles);
+}
+
+// model changed while filtered: positions are stale, rebuild the view
+void DirectoryPresenter::refilterView() {
+    QList<QString> oldSelection = selectedPaths();
+    populateView();
+    if(!oldSelection.isEmpty())
+        selectAndFocus(oldSelection.last());
+}
+
+int DirectoryPresenter::viewDirCount() const {
+    if(!mShowDirs || !model)
+        return 0;
+    return isFiltered() ? static_cast<int>(filteredDirs.size()) : model->dirCount();
+}
+
+int DirectoryPresenter::viewCount() const {
+    if(!model)
+        return 0;
+    int fileCount = isFiltered() ? static_cast<int>(filteredFiles.size()) : model->fileCount();
+    return viewDirCount() + fileCount;
+}
+
+bool DirectoryPresenter::isDirItem(int viewIndex) const {
+    return viewIndex < viewDirCount();
+}
+
+int DirectoryPresenter::dirIndexAt(int viewIndex) const {
+    if(!isFiltered())
+        return viewIndex;
+    if(viewIndex < 0 || viewIndex >= static_cast<int>(filteredDirs.size()))
+        return -1;
+    return filteredDirs[viewIndex];
+}
+
+int DirectoryPresenter::fileIndexAt(int viewIndex) const {
+    int index = viewIndex - viewDirCount();
+    if(!isFiltered())
+        return index;
+    if(index < 0 || index >= static_cast<int>(filteredFiles.size()))
+        return -1;
+    return filteredFiles[index];
+}
+
+int DirectoryPresenter::viewIndexOfDir(int dirIndex) const {
+    if(!isFiltered() || dirIndex < 0)
+        return dirIndex;
+    auto it = std::lower_bound(filteredDirs.begin(), filteredDirs.end(), dirIndex);
+    if(it == filteredDirs.end() || *it != dirIndex)
+        return -1;
+    return static_cast<int>(it - filteredDirs.begin());
+}
+
+int DirectoryPresenter::viewIndexOfFile(int fileIndex) const {
+    if(fileIndex < 0)
+        return -1;
+    if(!isFiltered())
+        return viewDirCount() + fileIndex;
+    auto it = std::lower_bound(filteredFiles.begin(), filteredFiles.end(), fileIndex);
+    if(it == filteredFiles.end() || *it != fileIndex)
+        return -1;
+    return viewDirCount() + static_cast<int>(it - filteredFiles.begin());
+}
+
+//------------------------------------------------------------------------------
+
 void DirectoryPresenter::onFileRemoved(QString filePath, int index) {
     Q_UNUSED(filePath)
     if(!view)
         return;
+    if(isFiltered()) {
+        refilterView();
+        return;
+    }
+    // indexes shift; in-flight results find their item by path
     view->removeItem(mShowDirs ? index + model->dirCount() : index);
 }
 
@@ -81,6 +201,11 @@ void DirectoryPresenter::onFileRenamed(QString fromPath, int indexFrom, QString
     Q_UNUSED(toPath)
     if(!view)
         return;
+    if(isFiltered()) {
+        refilterView();
+        return;
+    }
+    // indexes shift; in-flight results find their item by path
     if(mShowDirs) {
         indexFrom += model->dirCount();
         indexTo += model->dirCount();
@@ -102,21 +227,48 @@ void DirectoryPresenter::onFileRenamed(QString fromPath, int indexFrom, QString
 void DirectoryPresenter::onFileAdded(QString filePath) {
     if(!view)
         return;
+    if(isFiltered()) {
+        refilterView();
+        return;
+    }
+    // indexes shift; in-flight results find their item by path
     int index = model->indexOfFile(filePath);
     view->insertItem(mShowDirs ? model->dirCount() + index : index);
 }
 
+void DirectoryPresenter::onFilesInserted(QList<int> indexes) {
+    if(!view || indexes.isEmpty())
+        return;
+    if(isFiltered()) {
+        refilterView();
+        return;
+    }
+    // indexes shift; in-flight results find their item by path
+    if(mShowDirs) {
+        int offset = model->dirCount();
+        for(auto &index : indexes)
+            index += offset;
+    }
+    view->insertItems(indexes);
+}
+
 void DirectoryPresenter::onFileModified(QString filePath) {
     if(!view)
         return;
-    int index = model->indexOfFile(filePath);
-    view->reloadItem(mShowDirs ? model->dirCount() + index : index);
+    int index = viewIndexOfFile(model->indexOfFile(filePath));
+    if(index != -1)
+        view->reloadItem(index);
 }
 
 void DirectoryPresenter::onDirRemoved(QString dirPath, int index) {
     Q_UNUSED(dirPath)
     if(!view || !mShowDirs)
         return;
+    if(isFiltered()) {
+        refilterView();
+        return;
+    }
+    // indexes shift; in-flight results find their item by path
     view->removeItem(index);
 }
 
@@ -125,6 +277,11 @@ void DirectoryPresenter::onDirRenamed(QString fromPath, int indexFrom, QString t
     Q_UNUSED(toPath)
     if(!view || !mShowDirs)
         return;
+    if(isFiltered()) {
+        refilterView();
+        return;
+    }
+    // indexes shift; in-flight results find their item by path
     auto oldSelection = view->selection();
     view->removeItem(indexFrom);
     view->insertItem(indexTo);
@@ -142,6 +299,11 @@ void DirectoryPresenter::onDirRenamed(QString fromPath, int indexFrom, QString t
 void DirectoryPresenter::onDirAdded(QString dirPath) {
     if(!view || !mShowDirs)
         return;
+    if(isFiltered()) {
+        refilterView();
+        return;
+    }
+    // indexes shift; in-flight results find their item by path
     int index = model->indexOfDir(dirPath);
     view->insertItem(index);
 }
@@ -159,19 +321,13 @@ void DirectoryPresenter::setShowDirs(bool mode) {
 
 QList<QString> DirectoryPresenter::selectedPaths() const {
     QList<QString> paths;
-    if(!view)
+    if(!view || !model)
         return paths;
-    if(mShowDirs) {
-        for(auto i : view->selection()) {
-            if(i < model->dirCount())
-                paths << model->fileInfoAt(i).absolutePath();
-            else
-                paths << model->fileInfoAt(i - model->dirCount()).absoluteFilePath();
-        }
-    } else {
-        for(auto i : view->selection()) {
-            paths << model->fileInfoAt(i).absoluteFilePath();
-        }
+    for(auto i : view->selection()) {
+        if(isDirItem(i))
+            paths << model->dirPathAt(dirIndexAt(i));
+        else
+            paths << model->filePathAt(fileIndexAt(i));
     }
     return paths;
 }
@@ -179,62 +335,63 @@ QList<QString> DirectoryPresenter::selectedPaths() const {
 void DirectoryPresenter::generateThumbnails(QList<int> indexes, int size, bool crop, bool force) {
     if(!view || !model)
         return;
-    thumbnailer.clearTasks();
+    // indexes come in priority order (visible first)
+    // the thumbnailer keeps already queued tasks and only re-prioritizes them
+    // view index is used as the item id; results from before a repopulate are dropped
+    QList<QString> paths;
+    QList<int> ids;
+    QList<bool> dirs;
+    paths.reserve(indexes.count());
+    ids.reserve(indexes.count());
+    dirs.reserve(indexes.count());
     if(!mShowDirs) {
         for(int i : indexes)
-            thumbnailer.getThumbnailAsync(model->fileInfoAt(i).absoluteFilePath(), size, crop, force);
+            paths << model->filePathAt(fileIndexAt(i));
+        thumbnailer.getThumbnailsAsync(paths, indexes, generation, size, crop, force);
         return;
     }
     for(int i : indexes) {
-        if(i < model->dirCount()) {
-            // tmp ------------------------------------------------------------
-            // gen thumb for a directory
-            // TODO: optimize & move dir icon loading to shared res; then overlay
-            // the mini-thumbs on top (similar to dolphin)
-            QSvgRenderer svgRenderer;
-            svgRenderer.load(QString(":/res/icons/common/other/folder32-scalable.svg"));
-            int factor = (size * 0.90f) / svgRenderer.defaultSize().width();
-            QPixmap *pixmap = new QPixmap(svgRenderer.defaultSize() * factor);
-            pixmap->fill(Qt::transparent);
-            QPainter pixPainter(pixmap);
-            svgRenderer.render(&pixPainter);
-            pixPainter.end();
-
-            ImageLib::recolor(*pixmap, settings->colorScheme().icons);
-
-            std::shared_ptr<Thumbnail> thumb(new Thumbnail(model->fileInfoAt(i).absolutePath(),
+        if(isDirItem(i)) {
+            // shared base icon right away; the mosaic of child images follows asynchronously
+            QString dirPath = model->dirPathAt(dirIndexAt(i));
+            std::shared_ptr<Thumbnail> thumb(new Thumbnail(QFileInfo(dirPath).fileName(),
                                                            "Folder",
                                                            size,
-                                                           std::shared_ptr<QPixmap>(pixmap)));
-            // ^----------------------------------------------------------------
+                                                           shrRes->folderIconPixmap(size, settings->colorScheme().icons, qApp->devicePixelRatio())));
             view->setThumbnail(i, thumb);
+            paths << dirPath;
+            ids << i;
+            dirs << true;
         } else {
-            QString path = model->fileInfoAt(i - model->dirCount()).absoluteFilePath();
-            thumbnailer.getThumbnailAsync(path, size, crop, force);
+            paths << model->filePathAt(fileIndexAt(i));
+            ids << i;
+            dirs << false;
         }
     }
+    thumbnailer.getThumbnailsAsync(paths, ids, generation, size, crop, force, dirs);
 }
 
-void DirectoryPresenter::onThumbnailReady(std::shared_ptr<Thumbnail> thumb, QString filePath) {
-    if(!view || !model)
-        return;
-    int index = model->indexOfFile(filePath);
-    if(index == -1)
+// items may have moved since the request; the id is only a hint
+void DirectoryPresenter::onThumbnailReady(std::shared_ptr<Thumbnail> thumb, QString filePath, int id, int _generation) {
+    Q_UNUSED(id)
+    if(!view || !model || _generation != generation)
         return;
-    view->setThumbnail(mShowDirs ? model->dirCount() + index : index, thumb);
+    int index;
+    if(mShowDirs && model->containsDir(filePath))
+        index = viewIndexOfDir(model->indexOfDir(filePath));
+    else
+        index = viewIndexOfFile(model->indexOfFile(filePath));
+    if(index != -1)
+        view->setThumbnail(index, thumb);
 }
 
 void DirectoryPresenter::onItemActivated(int absoluteIndex) {
     if(!model)
         return;
-    if(!mShowDirs) {
-        emit fileActivated(model->fileInfoAt(absoluteIndex).absoluteFilePath());
-        return;
-    }
-    if(absoluteIndex < model->dirCount())
-        emit dirActivated(model->fileInfoAt(absoluteIndex).absolutePath());
+    if(isDirItem(absoluteIndex))
+        emit dirActivated(model->dirPathAt(dirIndexAt(absoluteIndex)));
     else
-        emit fileActivated(model->fileInfoAt(absoluteIndex - model->dirCount()).absoluteFilePath());
+        emit fileActivated(model->filePathAt(fileIndexAt(absoluteIndex)));
 }
 
 void DirectoryPresenter::onDraggedOut() {
@@ -244,7 +401,7 @@ void DirectoryPresenter::onDraggedOut() {
 void DirectoryPresenter::onDraggedOver(int index) {
     if(!model || view->selection().contains(index))
         return;
-    if(showDirs() && index < model->dirCount())
+    if(isDirItem(index))
         view->setDragHover(index);
 
 }
@@ -258,7 +415,7 @@ void DirectoryPresenter::onDroppedInto(const QMimeData *data, QObject *source, i
         return;
     // ignore drops into a file
     // todo: drop into a current dir when target is a file
-    if(showDirs() && targetIndex >= model->dirCount())
+    if(targetIndex != -1 && !isDirItem(targetIndex))
         return;
 
     // convert urls to qstrings
@@ -269,8 +426,8 @@ void DirectoryPresenter::onDroppedInto(const QMimeData *data, QObject *source, i
 
     // get target dir path
     QString destDir;
-    if(showDirs() && targetIndex < model->dirCount())
-       destDir = model->fileInfoAt(targetIndex).absolutePath();
+    if(targetIndex != -1 && isDirItem(targetIndex))
+       destDir = model->dirPathAt(dirIndexAt(targetIndex));
     if(destDir.isEmpty()) // fallback to the current dir
         destDir = model->directoryPath();
     pathList.removeAll(destDir); // remove target dir from source list
@@ -282,14 +439,14 @@ void DirectoryPresenter::onDroppedInto(const QMimeData *data, QObject *source, i
 void DirectoryPresenter::selectAndFocus(QString path) {
     if(!model || !view || path.isEmpty())
         return;
-    if(model->containsDir(path) && showDirs()) {
-        int dirIndex = model->indexOfDir(path);
-        view->select(dirIndex);
-        view->focusOn(dirIndex);
-    } else if(model->containsFile(path)) {
-        int fileIndex = showDirs() ? model->indexOfFile(path) + model->dirCount() : model->indexOfFile(path);
-        view->select(fileIndex);
-        view->focusOn(fileIndex);
+    int index = -1;
+    if(model->containsDir(path) && showDirs())
+        index = viewIndexOfDir(model->indexOfDir(path));
+    else if(model->containsFile(path))
+        index = viewIndexOfFile(model->indexOfFile(path));
+    if(index != -1) {
+        view->select(index);
+        view->focusOn(index);
     }
 }
 
@@ -5,12 +5,10 @@
 #include "gui/idirectoryview.h"
 #include "components/thumbnailer/thumbnailer.h"
 #include "directorymodel.h"
+#include "directorymanager/namefilter.h"
 #include "sharedresources.h"
 #include <QMimeData>
 
-//tmp
-#include <QtSvg/QSvgRenderer>
-
 class DirectoryPresenter : public QObject {
     Q_OBJECT
 public:
@@ -27,6 +25,8 @@ public:
     void onFileRenamed(QString fromPath, int indexFrom, QString toPath, int indexTo);
     void onFileAdded(QString filePath);
     void onFileModified(QString filePath);
+    // ascending model indexes, e.g. a merged scan batch
+    void onFilesInserted(QList<int> indexes);
 
     void onDirRemoved(QString dirPath, int index);
     void onDirRenamed(QString fromPath, int indexFrom, QString toPath, int indexTo);
@@ -37,6 +37,9 @@ public:
 
     QList<QString> selectedPaths() const;
 
+    // shows only entries with `text` in the name; empty text shows all
+    void setFilter(const QString &text);
+    bool isFiltered() const;
 
 signals:
     void dirActivated(QString dirPath);
@@ -50,7 +53,7 @@ public slots:
 
 private slots:
     void generateThumbnails(QList<int>, int, bool, bool);
-    void onThumbnailReady(std::shared_ptr<Thumbnail> thumb, QString filePath);
+    void onThumbnailReady(std::shared_ptr<Thumbnail> thumb, QString filePath, int id, int _generation);
     void populateView();
     void onItemActivated(int absoluteIndex);
     void onDraggedOut();
@@ -58,8 +61,26 @@ private slots:
 
     void onDroppedInto(const QMimeData *data, QObject *source, int targetIndex);
 private:
+    // view index <-> model index, the filter and folders taken into account
+    int viewDirCount() const;
+    int viewCount() const;
+    bool isDirItem(int viewIndex) const;
+    int dirIndexAt(int viewIndex) const;
+    int fileIndexAt(int viewIndex) const;
+    // -1 if filtered out
+    int viewIndexOfDir(int dirIndex) const;
+    int viewIndexOfFile(int fileIndex) const;
+    void updateFilter();
+    void refilterView();
+
     std::shared_ptr<IDirectoryView> view = nullptr;
     std::shared_ptr<DirectoryModel> model = nullptr;
     Thumbnailer thumbnailer;
     bool mShowDirs;
+    // bumped whenever view indexes change
+    int generation = 0;
+    NameFilter filter;
+    QString filterDirectory;
+    // model positions of the visible entries while filtered, in list order
+    std::vector<int> filteredDirs, filteredFiles;
 };
@@ -21,6 +21,8 @@ bool Loader::isLoading(QString path) {
 }
 
 std::shared_ptr<Image> Loader::load(QString path) {
+    // the ui would freeze for the whole decode; use loadAsyncPriority() there
+    Q_ASSERT(QThread::currentThread() != QCoreApplication::instance()->thread());
     return ImageFactory::createImage(path);
 }
 
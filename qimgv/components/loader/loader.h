@@ -1,6 +1,8 @@
 #pragma once
 
 #include <QThreadPool>
+#include <QThread>
+#include <QCoreApplication>
 #include "components/cache/thumbnailcache.h"
 #include "loaderrunnable.h"
 
@@ -8,6 +10,7 @@ class Loader : public QObject {
     Q_OBJECT
 public:
     explicit Loader();
+    // decodes on the calling thread
     std::shared_ptr<Image> load(QString path);
     void loadAsyncPriority(QString path);
     void loadAsync(QString path);
@@ -17,7 +20,7 @@ public:
     bool isLoading(QString path);
 private:
     QHash<QString, LoaderRunnable*> tasks;
-    QThreadPool *pool;    
+    QThreadPool *pool;
     void clearPool();
     void doLoadAsync(QString path, int priority);
 
@@ -10,5 +10,9 @@ void LoaderRunnable::run() {
     //t.start();
     auto image = ImageFactory::createImage(path);
     //qDebug() << "L: " << t.elapsed();
+    // read the metadata here while the file is still hot in the page cache;
+    // guiSetImage() then gets the cached tags without touching the disk
+    if(image)
+        image->loadExifTags();
     emit finished(image, path);
 }
@@ -1,7 +1,10 @@
 #include "thumbnailer.h"
 
+// max time spent delivering thumbnails per event loop pass
+#define DRAIN_BUDGET_MS 8
+
 Thumbnailer::Thumbnailer() {
-    cache = new ThumbnailCache();
+    cache = ThumbnailCache::getInstance();
     pool = new QThreadPool(this);
     int threads = settings->thumbnailerThreadCount();
     int globalThreads = QThreadPool::globalInstance()->maxThreadCount();
@@ -11,40 +14,134 @@ Thumbnailer::Thumbnailer() {
 }
 
 Thumbnailer::~Thumbnailer() {
-    pool->clear();
+    clearTasks();
     pool->waitForDone();
 }
 
+// runs queued tasks to completion
+// note: task results are delivered via the event loop, so we have to spin it here
 void Thumbnailer::waitForDone() {
-    pool->waitForDone();
+    while(!queue.isEmpty() || !runningTasks.isEmpty() || !pendingResults.isEmpty()) {
+        pool->waitForDone();
+        QCoreApplication::processEvents();
+    }
 }
 
 void Thumbnailer::clearTasks() {
-    pool->clear();
+    queue.clear();
+    queuedTasks.clear();
 }
 
 std::shared_ptr<Thumbnail> Thumbnailer::getThumbnail(QString filePath, int size) {
-    return ThumbnailerRunnable::generate(nullptr, filePath, size, false, false);
+    auto thumbnail = ThumbnailerRunnable::generate(nullptr, filePath, size, false, false);
+    thumbnail->createPixmap(qApp->devicePixelRatio());
+    return thumbnail;
+}
+
+void Thumbnailer::getThumbnailAsync(QString path, int size, bool crop, bool force, int id, int generation, bool dir) {
+    ThumbnailTask task{ path, size, crop };
+    auto running = runningTasks.find(task);
+    if(running != runningTasks.end() && !force) {
+        running->id = id;
+        running->generation = generation;
+        return;
+    }
+    auto queued = queuedTasks.find(task);
+    if(queued != queuedTasks.end()) {
+        queued->force |= force;
+        queued->id = id;
+        queued->generation = generation;
+    } else {
+        queue.append(task);
+        queuedTasks.insert(task, ThumbnailTaskState{ force, id, generation, dir });
+    }
+    startQueuedTasks();
 }
 
-void Thumbnailer::getThumbnailAsync(QString path, int size, bool crop, bool force) {
-    if(!runningTasks.contains(path, size))
-        startThumbnailerThread(path, size, crop, force);
+void Thumbnailer::getThumbnailsAsync(QList<QString> paths, QList<int> ids, int generation, int size, bool crop, bool force, QList<bool> dirs) {
+    QList<ThumbnailTask> newQueue;
+    QHash<ThumbnailTask, ThumbnailTaskState> prioritized;
+    newQueue.reserve(queue.count() + paths.count());
+    for(int i = 0; i < paths.count(); i++) {
+        ThumbnailTask task{ paths.at(i), size, crop };
+        if(prioritized.contains(task))
+            continue;
+        auto running = runningTasks.find(task);
+        if(running != runningTasks.end() && !force) {
+            // already in progress; just update where the result goes
+            running->id = ids.value(i, -1);
+            running->generation = generation;
+            continue;
+        }
+        prioritized.insert(task, ThumbnailTaskState{ force, ids.value(i, -1), generation, dirs.value(i, false) });
+        newQueue.append(task);
+    }
+    // keep the rest in their old order, behind the new requests.
+    // tasks for a different size / crop mode / generation are stale, drop them
+    for(auto &task : queue) {
+        ThumbnailTaskState queued = queuedTasks.value(task);
+        if(task.size != size || task.crop != crop || queued.generation != generation) {
+            queuedTasks.remove(task);
+            continue;
+        }
+        auto requested = prioritized.find(task);
+        if(requested != prioritized.end()) {
+            requested->force |= queued.force;
+            continue;
+        }
+        newQueue.append(task);
+    }
+    queue.swap(newQueue);
+    for(auto i = prioritized.constBegin(); i != prioritized.constEnd(); ++i)
+        queuedTasks.insert(i.key(), i.value());
+    startQueuedTasks();
 }
 
-void Thumbnailer::startThumbnailerThread(QString filePath, int size, bool crop, bool force) {
-    auto runnable = new ThumbnailerRunnable(settings->useThumbnailCache() ? cache : nullptr, filePath, size, crop, force);
-    connect(runnable, &ThumbnailerRunnable::taskStart, this, &Thumbnailer::onTaskStart);
-    connect(runnable, &ThumbnailerRunnable::taskEnd, this, &Thumbnailer::onTaskEnd);
+// keep the pool fed with at most maxThreadCount tasks.
+// everything else stays in our own queue so it can be re-prioritized
+void Thumbnailer::startQueuedTasks() {
+    while(!queue.isEmpty() && runningTasks.count() < pool->maxThreadCount()) {
+        ThumbnailTask task = queue.takeFirst();
+        startThumbnailerThread(task, queuedTasks.take(task));
+    }
+}
+
+void Thumbnailer::startThumbnailerThread(const ThumbnailTask &task, const ThumbnailTaskState &state) {
+    auto runnable = new ThumbnailerRunnable(settings->useThumbnailCache() ? cache : nullptr, &results, task, state);
+    connect(runnable, &ThumbnailerRunnable::resultsAvailable, this, &Thumbnailer::drainResults, Qt::QueuedConnection);
     runnable->setAutoDelete(true);
+    // replaces the entry, so a forced restart of a running task keeps the new routing
+    runningTasks.insert(task, state);
     pool->start(runnable);
 }
 
-void Thumbnailer::onTaskStart(QString filePath, int size) {
-    runningTasks.insert(filePath, size);
-}
+// Delivers finished thumbnails in batches. Pixmaps are created here (gui thread);
+// widget updates from one batch end up in a single scene repaint.
+// Whatever does not fit into the time budget is delivered on the next pass
+void Thumbnailer::drainResults() {
+    drainScheduled = false;
+    for(auto &result : results.takeAll()) {
+        // routing may have been updated while the task was running
+        auto running = runningTasks.find(result.task);
+        if(running != runningTasks.end()) {
+            result.state = running.value();
+            runningTasks.erase(running);
+        }
+        pendingResults.append(result);
+    }
+    startQueuedTasks();
 
-void Thumbnailer::onTaskEnd(std::shared_ptr<Thumbnail> thumbnail, QString filePath) {
-    runningTasks.remove(filePath, thumbnail->size());
-    emit thumbnailReady(thumbnail, filePath);
+    QElapsedTimer timer;
+    timer.start();
+    qreal dpr = qApp->devicePixelRatio();
+    while(!pendingResults.isEmpty() && timer.elapsed() < DRAIN_BUDGET_MS) {
+        ThumbnailResult result = pendingResults.takeFirst();
+        result.thumbnail->createPixmap(dpr);
+        emit thumbnailReady(result.thumbnail, result.task.path, result.state.id, result.state.generation);
+    }
+    // give the view a chance to repaint before continuing
+    if(!pendingResults.isEmpty() && !drainScheduled) {
+        drainScheduled = true;
+        QTimer::singleShot(0, this, &Thumbnailer::drainResults);
+    }
 }
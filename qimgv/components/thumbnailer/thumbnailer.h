@@ -1,6 +1,10 @@
 #pragma once
 
 #include <QThreadPool>
+#include <QCoreApplication>
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QTimer>
 #include "components/thumbnailer/thumbnailerrunnable.h"
 #include "components/cache/thumbnailcache.h"
 #include "settings.h"
@@ -11,23 +15,38 @@ class Thumbnailer : public QObject
 public:
     explicit Thumbnailer();
     ~Thumbnailer();
+    // gui thread only
     static std::shared_ptr<Thumbnail> getThumbnail(QString filePath, int size);
     void clearTasks();
     void waitForDone();
 
 public slots:
-    void getThumbnailAsync(QString path, int size, bool crop, bool force);
+    // appends a single task at the lowest priority
+    void getThumbnailAsync(QString path, int size, bool crop, bool force, int id = -1, int generation = 0, bool dir = false);
+    // moves the given paths in front of the queue, in list order.
+    // tasks that are already queued are only re-prioritized.
+    // ids[i] / generation are handed back with the result for paths[i];
+    // queued tasks from another generation are dropped.
+    // dirs[i] marks directories (folder mosaics); missing entries are files
+    void getThumbnailsAsync(QList<QString> paths, QList<int> ids, int generation, int size, bool crop, bool force, QList<bool> dirs = QList<bool>());
 
 private:
     ThumbnailCache *cache;
     QThreadPool *pool;
-    void startThumbnailerThread(QString filePath, int size, bool crop, bool force);
-    QMultiMap<QString, int> runningTasks;
+    // pending tasks; front is the highest priority
+    QList<ThumbnailTask> queue;
+    QHash<ThumbnailTask, ThumbnailTaskState> queuedTasks, runningTasks;
+    // filled by workers, drained on the gui thread
+    ThumbnailResultQueue results;
+    // finished, but not yet delivered (out of frame budget)
+    QList<ThumbnailResult> pendingResults;
+    bool drainScheduled = false;
+    void startThumbnailerThread(const ThumbnailTask &task, const ThumbnailTaskState &state);
+    void startQueuedTasks();
 
 private slots:
-    void onTaskStart(QString filePath, int size);
-    void onTaskEnd(std::shared_ptr<Thumbnail> thumbnail, QString filePath);
+    void drainResults();
 
 signals:
-    void thumbnailReady(std::shared_ptr<Thumbnail> thumbnail, QString filePath);
+    void thumbnailReady(std::shared_ptr<Thumbnail> thumbnail, QString filePath, int id, int generation);
 };
@@ -1,18 +1,22 @@
 #include "thumbnailerrunnable.h"
 
-ThumbnailerRunnable::ThumbnailerRunnable(ThumbnailCache* _cache, QString _path, int _size, bool _crop, bool _force) :
-    path(_path),
-    size(_size),
-    crop(_crop),
-    force(_force),
-    cache(_cache)
+ThumbnailerRunnable::ThumbnailerRunnable(ThumbnailCache* _cache, ThumbnailResultQueue *_results, const ThumbnailTask &_task, const ThumbnailTaskState &_state) :
+    task(_task),
+    state(_state),
+    cache(_cache),
+    results(_results)
 {
 }
 
 void ThumbnailerRunnable::run() {
-    emit taskStart(path, size);
-    std::shared_ptr<Thumbnail> thumbnail = generate(cache, path, size, crop, force);
-    emit taskEnd(thumbnail, path);
+    std::shared_ptr<Thumbnail> thumbnail;
+    if(state.dir)
+        thumbnail = generateFolder(cache, task.path, task.size);
+    else
+        thumbnail = generate(cache, task.path, task.size, task.crop, state.force);
+    // only the first result of a batch wakes up the gui thread
+    if(results->push(ThumbnailResult{ thumbnail, task, state }))
+        emit resultsAvailable();
 }
 
 QString ThumbnailerRunnable::generateIdString(QString path, int size, bool crop) {
@@ -38,42 +42,29 @@ std::shared_ptr<Thumbnail> ThumbnailerRunnable::generate(ThumbnailCache* cache,
 
     if(!image) {
         if(imgInfo.type() == DocumentType::NONE) {
-            std::shared_ptr<Thumbnail> thumbnail(new Thumbnail(imgInfo.fileName(), "", size, nullptr));
+            std::shared_ptr<Thumbnail> thumbnail(new Thumbnail(imgInfo.fileName(), "", size, std::shared_ptr<QImage>()));
             return thumbnail;
         }
-        std::pair<QImage*, QSize> pair;
-        if(imgInfo.type() == VIDEO)
-            pair = createVideoThumbnail(path, size, crop);
-        else
-            pair = createThumbnail(imgInfo.filePath(), imgInfo.format().toStdString().c_str(), size, crop);
-        image.reset(pair.first);
-        QSize originalSize = pair.second;
-
-        image = ImageLib::exifRotated(std::move(image), imgInfo.exifOrientation());
-
-        // put in image info
-        image->setText("originalWidth", QString::number(originalSize.width()));
-        image->setText("originalHeight", QString::number(originalSize.height()));
-        image->setText("lastModified", time);
-
-        if(imgInfo.type() == ANIMATED)
-            image->setText("label", " [a]");
-        else if(imgInfo.type() == VIDEO)
-            image->setText("label", " [v]");
-
+        if(cache && size < masterSize()) {
+            // derive from the master thumbnail; the source is decoded at most once for all sizes
+            std::unique_ptr<QImage> master = masterThumbnail(cache, imgInfo, crop, force);
+            image = scaledThumbnail(*master, size, crop);
+        } else {
+            image = createThumbnailImage(imgInfo, size, crop);
+        }
+        // the file is in the page cache now, index it while at it
+        if(metadataIndex && metadataIndex->indexOnRead() && imgInfo.type() != VIDEO)
+            metadataIndex->ensure(imgInfo.filePath());
         if(cache) {
             // save thumbnail if it makes sense
             // FIXME: avoid too much i/o
-            if(originalSize.width() > size || originalSize.height() > size)
+            if(image->text("originalWidth").toInt() > size || image->text("originalHeight").toInt() > size)
                 cache->saveThumbnail(image.get(), thumbnailId);
         }
     }
-    auto && tmpPixmap = new QPixmap(image->size());
-    *tmpPixmap = QPixmap::fromImage(*image);
-    tmpPixmap->setDevicePixelRatio(qApp->devicePixelRatio());
-
+    // no QPixmap here, see Thumbnail::createPixmap()
     QString label;
-    if(tmpPixmap->width() == 0) {
+    if(image->width() == 0) {
         label = "error";
     } else  {
         // put info into Thumbnail object
@@ -82,14 +73,179 @@ std::shared_ptr<Thumbnail> ThumbnailerRunnable::generate(ThumbnailCache* cache,
                 image->text("originalHeight") +
                 image->text("label");
     }
-    std::shared_ptr<QPixmap> pixmapPtr(tmpPixmap);
-    std::shared_ptr<Thumbnail> thumbnail(new Thumbnail(imgInfo.fileName(), label, size, pixmapPtr));
+    std::shared_ptr<QImage> imagePtr(image.release());
+    std::shared_ptr<Thumbnail> thumbnail(new Thumbnail(imgInfo.fileName(), label, size, imagePtr));
     return thumbnail;
 }
 
 ThumbnailerRunnable::~ThumbnailerRunnable() {
 }
 
+// Mosaics only use child thumbnails that are already cached, nothing is decoded here.
+// The result is cached on disk, tagged with the directory mtime and with the children
+// that had no thumbnail yet; it is rebuilt once any of those gets one
+std::shared_ptr<Thumbnail> ThumbnailerRunnable::generateFolder(ThumbnailCache *cache, QString path, int size) {
+    QString name = QFileInfo(path).fileName();
+    QColor iconColor = settings->colorScheme().icons;
+    QString thumbnailId = generateIdString(path + iconColor.name(), size, false);
+    QString time = QString::number(QFileInfo(path).lastModified().toMSecsSinceEpoch());
+    QStringList children;
+    bool listed = false;
+    if(cache) {
+        std::shared_ptr<QImage> cached(cache->readThumbnail(thumbnailId));
+        if(cached && cached->text("lastModified") == time) {
+            QStringList missing = cached->text("missing").split("\n", Qt::SkipEmptyParts);
+            if(std::none_of(missing.begin(), missing.end(), [cache](const QString &child) { return hasCachedTile(cache, child); }))
+                return std::shared_ptr<Thumbnail>(new Thumbnail(name, "Folder", size, cached));
+            children = cached->text("children").split("\n", Qt::SkipEmptyParts);
+            listed = true;
+        }
+    }
+    if(!listed)
+        children = folderPreviewFiles(path, 4);
+    // the base icon is shared, painting below detaches it
+    std::shared_ptr<QImage> image(new QImage(shrRes->folderIcon(size, iconColor)));
+    QStringList missing;
+    if(!children.isEmpty()) {
+        // 2x2 grid inside the folder body (below the tab)
+        QRectF body(image->width() * 0.08, image->height() * 0.28, image->width() * 0.84, image->height() * 0.64);
+        int columns = (children.count() > 1) ? 2 : 1;
+        int rows = (children.count() > 2) ? 2 : 1;
+        qreal gap = image->width() * 0.03;
+        qreal cellWidth  = (body.width()  - gap * (columns + 1)) / columns;
+        qreal cellHeight = (body.height() - gap * (rows + 1)) / rows;
+        int tileSize = static_cast<int>(qMin(cellWidth, cellHeight));
+        QPainter painter(image.get());
+        for(int i = 0; i < children.count(); i++) {
+            std::unique_ptr<QImage> tile = folderPreviewTile(cache, children.at(i), tileSize);
+            if(!tile || tile->isNull()) {
+                missing << children.at(i);
+                continue;
+            }
+            QRectF cell(body.left() + gap + (i % columns) * (cellWidth + gap),
+                        body.top()  + gap + (i / columns) * (cellHeight + gap),
+                        cellWidth, cellHeight);
+            QRectF target(QPointF(), QSizeF(tile->size()));
+            target.moveCenter(cell.center());
+            painter.drawImage(target.topLeft(), *tile);
+        }
+    }
+    if(cache) {
+        image->setText("lastModified", time);
+        image->setText("children", children.join("\n"));
+        image->setText("missing", missing.join("\n"));
+        cache->saveThumbnail(image.get(), thumbnailId);
+    }
+    return std::shared_ptr<Thumbnail>(new Thumbnail(name, "Folder", size, image));
+}
+
+// first supported files in directory order; no sorting, no recursion
+QStringList ThumbnailerRunnable::folderPreviewFiles(const QString &dirPath, int count) {
+    static const QList<QByteArray> formats = settings->supportedFormats();
+    QStringList files;
+    QDirIterator it(dirPath, QDir::Files | QDir::Readable);
+    while(it.hasNext() && files.count() < count) {
+        it.next();
+        if(formats.contains(it.fileInfo().suffix().toLower().toLatin1()))
+            files << it.filePath();
+    }
+    return files;
+}
+
+bool ThumbnailerRunnable::hasCachedTile(ThumbnailCache *cache, const QString &path) {
+    return cache->containsMasterThumbnail(generateIdString(path, masterSize(), true))
+            || cache->exists(generateIdString(path, masterSize(), true))
+            || cache->exists(generateIdString(path, masterSize(), false));
+}
+
+// only from thumbnails that are already cached (memory or disk), never decodes
+std::unique_ptr<QImage> ThumbnailerRunnable::folderPreviewTile(ThumbnailCache *cache, const QString &path, int size) {
+    if(!cache)
+        return nullptr;
+    std::unique_ptr<QImage> image(cache->readMasterThumbnail(generateIdString(path, masterSize(), true)));
+    if(!image)
+        image.reset(cache->readThumbnail(generateIdString(path, masterSize(), true)));
+    if(!image)
+        image.reset(cache->readThumbnail(generateIdString(path, masterSize(), false)));
+    if(!image)
+        return nullptr;
+    return scaledThumbnail(*image, size, true);
+}
+
+// largest thumbnail size in use (folder view at max zoom)
+int ThumbnailerRunnable::masterSize() {
+    return static_cast<int>(MASTER_THUMBNAIL_SIZE * qApp->devicePixelRatio());
+}
+
+// memory -> disk -> decode. The result is stored in both caches
+std::unique_ptr<QImage> ThumbnailerRunnable::masterThumbnail(ThumbnailCache *cache, const DocumentInfo &imgInfo, bool crop, bool force) {
+    QString masterId = generateIdString(imgInfo.filePath(), masterSize(), crop);
+    QString time = QString::number(imgInfo.lastModified().toMSecsSinceEpoch());
+    std::unique_ptr<QImage> master;
+    if(!force) {
+        master.reset(cache->readMasterThumbnail(masterId));
+        if(!master)
+            master.reset(cache->readThumbnail(masterId));
+        if(master && master->text("lastModified") != time)
+            master.reset(nullptr);
+    }
+    if(!master) {
+        master = createThumbnailImage(imgInfo, masterSize(), crop);
+        if(master->text("originalWidth").toInt() > masterSize() || master->text("originalHeight").toInt() > masterSize())
+            cache->saveThumbnail(master.get(), masterId);
+    }
+    cache->storeMasterThumbnail(masterId, *master);
+    return master;
+}
+
+// decodes, rotates and tags a thumbnail image. No cache involved
+std::unique_ptr<QImage> ThumbnailerRunnable::createThumbnailImage(const DocumentInfo &imgInfo, int size, bool crop) {
+    std::pair<QImage*, QSize> pair(nullptr, QSize());
+    if(imgInfo.type() == VIDEO) {
+        pair = createVideoThumbnail(imgInfo.filePath(), size, crop);
+    } else {
+#ifdef USE_EXIV2
+        // camera files usually carry a big enough preview; skip decoding the main image
+        if(imgInfo.type() == STATIC && mayHaveEmbeddedPreview(imgInfo.format()))
+            pair = createThumbnailFromPreview(imgInfo.filePath(), size, crop);
+#endif
+        if(!pair.first)
+            pair = createThumbnail(imgInfo.filePath(), imgInfo.format().toStdString().c_str(), size, crop);
+    }
+    std::unique_ptr<QImage> image(pair.first);
+    QSize originalSize = pair.second;
+
+    image = ImageLib::exifRotated(std::move(image), imgInfo.exifOrientation());
+
+    // put in image info
+    image->setText("originalWidth", QString::number(originalSize.width()));
+    image->setText("originalHeight", QString::number(originalSize.height()));
+    image->setText("lastModified", QString::number(imgInfo.lastModified().toMSecsSinceEpoch()));
+
+    if(imgInfo.type() == ANIMATED)
+        image->setText("label", " [a]");
+    else if(imgInfo.type() == VIDEO)
+        image->setText("label", " [v]");
+    return image;
+}
+
+// derive a smaller thumbnail from an already generated one (keeps image info)
+std::unique_ptr<QImage> ThumbnailerRunnable::scaledThumbnail(const QImage &source, int size, bool crop) {
+    if(source.width() <= size && source.height() <= size)
+        return std::unique_ptr<QImage>(new QImage(source));
+    Qt::AspectRatioMode ARMode = crop ? Qt::KeepAspectRatioByExpanding : Qt::KeepAspectRatio;
+    QSize scaledSize = source.size().scaled(size, size, ARMode);
+    std::unique_ptr<QImage> result(new QImage(source.scaled(scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)));
+    if(crop && result->size() != QSize(size, size)) {
+        QRect clip(0, 0, size, size);
+        clip.moveCenter(result->rect().center());
+        result.reset(ImageLib::croppedRaw(result.get(), clip));
+    }
+    for(auto &key : source.textKeys())
+        result->setText(key, source.text(key));
+    return result;
+}
+
 std::pair<QImage*, QSize> ThumbnailerRunnable::createThumbnail(QString path, const char *format, int size, bool squared) {
     QImageReader *reader = new QImageReader(path, format);
     Qt::AspectRatioMode ARMode = squared?
@@ -153,7 +309,30 @@ std::pair<QImage*, QSize> ThumbnailerRunnable::createThumbnail(QString path, con
     return std::make_pair(result, originalSize);
 }
 
+// in-process via the player plugin; no temp files
 std::pair<QImage*, QSize> ThumbnailerRunnable::createVideoThumbnail(QString path, int size, bool squared) {
+    if(!VideoFrameGrabber::isAvailable())
+        return createVideoThumbnailExternal(path, size, squared);
+    QImage frame = VideoFrameGrabber::grab(path);
+    if(frame.isNull())
+        return std::make_pair(new QImage(), QSize());
+    Qt::AspectRatioMode ARMode = squared?
+                (Qt::KeepAspectRatioByExpanding):(Qt::KeepAspectRatio);
+    QSize scaledSize = frame.size().scaled(size, size, ARMode);
+    QImage scaled = frame.scaled(scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    QImage *result = nullptr;
+    if(squared) {
+        QRect clip(0, 0, size, size);
+        clip.moveCenter(scaled.rect().center());
+        result = ImageLib::croppedRaw(&scaled, clip);
+    } else {
+        result = new QImage(scaled);
+    }
+    return std::make_pair(result, frame.size());
+}
+
+// fallback: run mpv binary, read back a temporary png
+std::pair<QImage*, QSize> ThumbnailerRunnable::createVideoThumbnailExternal(QString path, int size, bool squared) {
     QFileInfo fi(path);
     QImageReader reader;
     QString tmpFilePath = settings->tmpDir() + fi.fileName() + ".png";
@@ -202,3 +381,78 @@ std::pair<QImage*, QSize> ThumbnailerRunnable::createVideoThumbnail(QString path
 
     return std::make_pair(result, originalSize);
 }
+
+#ifdef USE_EXIV2
+// jpeg and tiff-based raw formats
+bool ThumbnailerRunnable::mayHaveEmbeddedPreview(const QString &format) {
+    static const QStringList formats = { "jpg", "jpeg", "tif", "tiff", "dng", "nef", "nrw", "cr2",
+                                         "arw", "sr2", "srf", "orf", "rw2", "pef", "srw", "raf",
+                                         "3fr", "erf", "kdc", "mrw" };
+    return formats.contains(format, Qt::CaseInsensitive);
+}
+
+// Uses the smallest embedded preview which still covers the requested size.
+// Previews with a different aspect ratio (letterboxed, or a crop) are skipped.
+// Returns {nullptr, QSize()} when there is nothing suitable.
+std::pair<QImage*, QSize> ThumbnailerRunnable::createThumbnailFromPreview(QString path, int size, bool squared) {
+    Qt::AspectRatioMode ARMode = squared?
+                (Qt::KeepAspectRatioByExpanding):(Qt::KeepAspectRatio);
+    try {
+        auto image = Exiv2::ImageFactory::open(path.toStdString());
+        if(!image.get())
+            return std::make_pair(nullptr, QSize());
+        image->readMetadata();
+        if(metadataIndex)
+            metadataIndex->store(path, MetadataIndex::fromExif(*image));
+        QSize originalSize(image->pixelWidth(), image->pixelHeight());
+        if(originalSize.isEmpty())
+            return std::make_pair(nullptr, QSize());
+        QSize scaledSize = originalSize.scaled(size, size, ARMode);
+        // nothing to gain if the main image is tiny anyway
+        if(scaledSize.width() >= originalSize.width() || scaledSize.height() >= originalSize.height())
+            return std::make_pair(nullptr, QSize());
+        qreal originalAR = static_cast<qreal>(originalSize.width()) / originalSize.height();
+
+        Exiv2::PreviewManager previewManager(*image);
+        // sorted by size, smallest first
+        Exiv2::PreviewPropertiesList previews = previewManager.getPreviewProperties();
+        for(auto &props : previews) {
+            if(props.width_ < static_cast<uint32_t>(scaledSize.width()) ||
+               props.height_ < static_cast<uint32_t>(scaledSize.height()))
+                continue;
+            qreal previewAR = static_cast<qreal>(props.width_) / props.height_;
+            if(qAbs(previewAR - originalAR) > 0.02 * originalAR)
+                continue;
+            Exiv2::PreviewImage preview = previewManager.getPreviewImage(props);
+            QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char*>(preview.pData()),
+                                                      static_cast<int>(preview.size()));
+            QBuffer buffer(&data);
+            QImageReader reader(&buffer);
+            QSize previewScaledSize = reader.size().scaled(size, size, ARMode);
+            if(reader.supportsOption(QImageIOHandler::ScaledSize))
+                reader.setScaledSize(previewScaledSize);
+            QImage *result = new QImage();
+            if(!reader.read(result) || result->isNull()) {
+                delete result;
+                continue;
+            }
+            if(result->size() != previewScaledSize) {
+                QImage *tmp = new QImage(result->scaled(previewScaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+                delete result;
+                result = tmp;
+            }
+            if(squared) {
+                QRect clip(0, 0, size, size);
+                clip.moveCenter(result->rect().center());
+                QImage *tmp = ImageLib::croppedRaw(result, clip);
+                delete result;
+                result = tmp;
+            }
+            return std::make_pair(result, originalSize);
+        }
+    } catch (std::exception &) {
+        // no usable preview; the caller decodes the image instead
+    }
+    return std::make_pair(nullptr, QSize());
+}
+#endif
@@ -7,29 +7,84 @@
 #include <ctime>
 #include "sourcecontainers/thumbnail.h"
 #include "components/cache/thumbnailcache.h"
+#include "components/cache/metadataindex.h"
+#include "components/thumbnailer/videoframegrabber.h"
 #include "utils/imagefactory.h"
 #include "utils/imagelib.h"
+#include "utils/mpscqueue.h"
 #include "settings.h"
+#include "sharedresources.h"
 #include <memory>
+#include <algorithm>
 #include <QImageWriter>
+#include <QBuffer>
+#include <QDirIterator>
+
+// smaller thumbnails are derived from this one; matches the folder view max zoom
+#define MASTER_THUMBNAIL_SIZE 400
+
+// tasks are unique on (path, size, crop)
+struct ThumbnailTask {
+    QString path;
+    int size;
+    bool crop;
+};
+
+// everything else about a task. id / generation are opaque routing info for the caller
+struct ThumbnailTaskState {
+    bool force;
+    int id;
+    int generation;
+    // path is a directory; known by the caller, saves a stat on the worker
+    bool dir;
+};
+
+inline bool operator==(const ThumbnailTask &t1, const ThumbnailTask &t2) {
+    return t1.size == t2.size && t1.crop == t2.crop && t1.path == t2.path;
+}
+
+inline uint qHash(const ThumbnailTask &task, uint seed = 0) {
+    return qHash(task.path, seed) ^ static_cast<uint>(task.size << 1) ^ static_cast<uint>(task.crop);
+}
+
+struct ThumbnailResult {
+    std::shared_ptr<Thumbnail> thumbnail;
+    ThumbnailTask task;
+    ThumbnailTaskState state;
+};
+
+typedef MpscQueue<ThumbnailResult> ThumbnailResultQueue;
 
 class ThumbnailerRunnable : public QObject, public QRunnable {
     Q_OBJECT
 public:
-    ThumbnailerRunnable(ThumbnailCache* _cache, QString _path, int _size, bool _crop, bool _force);
+    ThumbnailerRunnable(ThumbnailCache* _cache, ThumbnailResultQueue *_results, const ThumbnailTask &_task, const ThumbnailTaskState &_state);
     ~ThumbnailerRunnable();
     void run();
     static std::shared_ptr<Thumbnail> generate(ThumbnailCache *cache, QString path, int size, bool crop, bool force);
-private:
+    static std::unique_ptr<QImage> createThumbnailImage(const DocumentInfo &imgInfo, int size, bool crop);
+    static std::unique_ptr<QImage> scaledThumbnail(const QImage &source, int size, bool crop);
     static QString generateIdString(QString path, int size, bool crop);
+    static int masterSize();
+    // folder icon with a mosaic of the first few child images (cached thumbnails only)
+    static std::shared_ptr<Thumbnail> generateFolder(ThumbnailCache *cache, QString path, int size);
+private:
+    static QStringList folderPreviewFiles(const QString &dirPath, int count);
+    static std::unique_ptr<QImage> folderPreviewTile(ThumbnailCache *cache, const QString &path, int size);
+    static bool hasCachedTile(ThumbnailCache *cache, const QString &path);
+    static std::unique_ptr<QImage> masterThumbnail(ThumbnailCache *cache, const DocumentInfo &imgInfo, bool crop, bool force);
     static std::pair<QImage*, QSize> createThumbnail(QString path, const char* format, int size, bool crop);
     static std::pair<QImage*, QSize> createVideoThumbnail(QString path, int size, bool crop);
-    QString path;
-    int size;
-    bool crop, force;
+    static std::pair<QImage*, QSize> createVideoThumbnailExternal(QString path, int size, bool crop);
+#ifdef USE_EXIV2
+    static bool mayHaveEmbeddedPreview(const QString &format);
+    static std::pair<QImage*, QSize> createThumbnailFromPreview(QString path, int size, bool crop);
+#endif
+    ThumbnailTask task;
+    ThumbnailTaskState state;
     ThumbnailCache* cache = nullptr;
+    ThumbnailResultQueue *results = nullptr;
 
 signals:
-    void taskStart(QString, int);
-    void taskEnd(std::shared_ptr<Thumbnail>, QString);
+    void resultsAvailable();
 };
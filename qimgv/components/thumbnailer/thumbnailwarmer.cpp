@@ -0,0 +1,95 @@
+#include "thumbnailwarmer.h"
+
+std::atomic<bool> ThumbnailWarmer::interrupted(false);
+
+ThumbnailWarmer::ThumbnailWarmer(QStringList _paths, QList<int> _sizes, bool _crop)
+    : paths(_paths),
+      sizes(_sizes),
+      crop(_crop),
+      nextIndex(0),
+      generated(0),
+      upToDate(0),
+      failed(0)
+{
+    std::sort(sizes.begin(), sizes.end(), std::greater<int>());
+    sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+    cache = ThumbnailCache::getInstance();
+    pool = new QThreadPool();
+    pool->setMaxThreadCount(QThread::idealThreadCount());
+}
+
+ThumbnailWarmer::~ThumbnailWarmer() {
+    pool->waitForDone();
+    delete pool;
+}
+
+void ThumbnailWarmer::interrupt() {
+    interrupted = true;
+}
+
+bool ThumbnailWarmer::run() {
+    timer.start();
+    // each worker keeps pulling files until the list is exhausted
+    for(int i = 0; i < pool->maxThreadCount(); i++)
+        pool->start(new ThumbnailWarmerRunnable(this));
+    while(!pool->waitForDone(1000))
+        printProgress();
+
+    qint64 elapsed = qMax(timer.elapsed(), qint64(1));
+    int processed = generated + upToDate + failed;
+    qDebug() << "\nProcessed" << processed << "of" << paths.count() << "files in"
+             << QString::number(elapsed / 1000.0, 'f', 1) << "s"
+             << "(" << QString::number(processed * 1000.0 / elapsed, 'f', 1) << "files/s )";
+    qDebug() << "Generated:" << generated << " Up to date:" << upToDate << " Failed:" << failed;
+    if(interrupted) {
+        qDebug() << "Interrupted. Run again to resume.";
+        return false;
+    }
+    return true;
+}
+
+void ThumbnailWarmer::printProgress() {
+    int processed = generated + upToDate + failed;
+    double rate = processed * 1000.0 / qMax(timer.elapsed(), qint64(1));
+    qDebug().noquote() << QString("[%1/%2] %3 files/s").arg(processed).arg(paths.count()).arg(rate, 0, 'f', 1);
+}
+
+void ThumbnailWarmer::processNext() {
+    int index;
+    while(!interrupted && (index = nextIndex++) < paths.count())
+        processFile(paths.at(index));
+}
+
+void ThumbnailWarmer::processFile(const QString &path) {
+    // stat-only check first; don't touch the image unless something is missing or stale
+    QDateTime modified = QFileInfo(path).lastModified();
+    QStringList ids;
+    bool stale = false;
+    for(auto size : sizes) {
+        ids << ThumbnailerRunnable::generateIdString(path, size, crop);
+        if(!stale && !cache->isUpToDate(ids.last(), modified))
+            stale = true;
+    }
+    if(!stale) {
+        upToDate++;
+        return;
+    }
+    DocumentInfo imgInfo(path);
+    if(imgInfo.type() == DocumentType::NONE) {
+        failed++;
+        return;
+    }
+    // decode once at the largest size
+    std::unique_ptr<QImage> master = ThumbnailerRunnable::createThumbnailImage(imgInfo, sizes.first(), crop);
+    if(!master || master->isNull()) {
+        failed++;
+        return;
+    }
+    // everything is saved (even small images) so the next run can skip this file
+    cache->saveThumbnail(master.get(), ids.first());
+    for(int i = 1; i < sizes.count(); i++) {
+        std::unique_ptr<QImage> scaled = ThumbnailerRunnable::scaledThumbnail(*master, sizes.at(i), crop);
+        cache->saveThumbnail(scaled.get(), ids.at(i));
+    }
+    generated++;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QObject>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QDebug>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include "components/thumbnailer/thumbnailerrunnable.h"
+
+// Headless bulk thumbnail generator used by --gen-thumbs.
+// Every file is decoded once at the largest requested size, smaller sizes are derived
+// from it. Files with up-to-date cache entries are skipped without decoding,
+// so an interrupted run can simply be restarted.
+class ThumbnailWarmer {
+public:
+    ThumbnailWarmer(QStringList _paths, QList<int> _sizes, bool _crop);
+    ~ThumbnailWarmer();
+    // blocks until done or interrupted; returns false when interrupted
+    bool run();
+    // safe to call from a signal handler
+    static void interrupt();
+
+private:
+    friend class ThumbnailWarmerRunnable;
+    void processNext();
+    void processFile(const QString &path);
+    void printProgress();
+
+    QStringList paths;
+    QList<int> sizes; // sorted, largest first
+    bool crop;
+    ThumbnailCache *cache = nullptr;
+    QThreadPool *pool = nullptr;
+    QElapsedTimer timer;
+    std::atomic<int> nextIndex, generated, upToDate, failed;
+    static std::atomic<bool> interrupted;
+};
+
+class ThumbnailWarmerRunnable : public QRunnable {
+public:
+    ThumbnailWarmerRunnable(ThumbnailWarmer *_warmer) : warmer(_warmer) {}
+    void run() { warmer->processNext(); }
+private:
+    ThumbnailWarmer *warmer;
+};
@@ -0,0 +1,44 @@
+#include "videoframegrabber.h"
+
+#ifdef _QIMGV_PLAYER_PLUGIN
+    #define QIMGV_PLAYER_PLUGIN _QIMGV_PLAYER_PLUGIN
+#else
+    #define QIMGV_PLAYER_PLUGIN ""
+#endif
+
+bool VideoFrameGrabber::isAvailable() {
+    return resolve() != nullptr;
+}
+
+QImage VideoFrameGrabber::grab(const QString &path) {
+    QImage frame;
+    auto fn = resolve();
+    if(fn)
+        fn(path, frame);
+    return frame;
+}
+
+// thread safe (static init)
+VideoFrameGrabber::GrabVideoFrameFn VideoFrameGrabber::resolve() {
+    static GrabVideoFrameFn fn = []() -> GrabVideoFrameFn {
+#ifndef USE_MPV
+        return nullptr;
+#endif
+        static QLibrary playerLib;
+        QFileInfo pluginFile;
+        for(auto dir : settings->playerPluginDirs()) {
+            pluginFile.setFile(dir + "/" + QIMGV_PLAYER_PLUGIN);
+            if(pluginFile.isFile() && pluginFile.isReadable()) {
+                playerLib.setFileName(pluginFile.absoluteFilePath());
+                break;
+            }
+        }
+        if(playerLib.fileName().isEmpty())
+            return nullptr;
+        auto grabFn = reinterpret_cast<GrabVideoFrameFn>(playerLib.resolve("GrabVideoFrame"));
+        if(!grabFn)
+            qDebug() << "VideoFrameGrabber: GrabVideoFrame not found in" << playerLib.fileName() << "- falling back to mpv binary";
+        return grabFn;
+    }();
+    return fn;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// Grabs video frames in-process using the player plugin (libmpv).
+// The plugin is loaded on first use and stays loaded.
+
+#include <QLibrary>
+#include <QImage>
+#include <QFileInfo>
+#include <QDebug>
+#include "settings.h"
+
+class VideoFrameGrabber {
+public:
+    // false if the plugin is missing or too old
+    static bool isAvailable();
+    // returns a null image on failure
+    static QImage grab(const QString &path);
+
+private:
+    typedef bool (*GrabVideoFrameFn)(const QString &path, QImage &frame);
+    static GrabVideoFrameFn resolve();
+};
@@ -44,8 +44,6 @@ void Core::readSettings() {
     bool showDirs = (settings->folderViewMode() == FV_EXT_FOLDERS);
     if(folderViewPresenter.showDirs() != showDirs)
         folderViewPresenter.setShowDirs(showDirs);
-    if(shuffle)
-        syncRandomizer();
 }
 
 void Core::showGui() {
@@ -112,6 +110,7 @@ void Core::connectComponents() {
     connect(mw, &MW::resizeRequested,       this, &Core::resize);
     connect(mw, &MW::renameRequested,       this, &Core::renameCurrentSelection);
     connect(mw, &MW::sortingSelected,       this, &Core::sortBy);
+    connect(mw, &MW::folderViewFilterChanged, &folderViewPresenter, &DirectoryPresenter::setFilter);
     connect(mw, &MW::showFoldersChanged,    this, &Core::setFoldersDisplay);
     connect(mw, &MW::discardEditsRequested, this, &Core::discardEdits);
     connect(mw, &MW::draggedOut,            this, qOverload<>(&Core::onDraggedOut));
@@ -125,11 +124,16 @@ void Core::connectComponents() {
     connect(model.get(), &DirectoryModel::fileRemoved,    this, &Core::onFileRemoved);
     connect(model.get(), &DirectoryModel::fileRenamed,    this, &Core::onFileRenamed);
     connect(model.get(), &DirectoryModel::fileModified,   this, &Core::onFileModified);
+    connect(model.get(), &DirectoryModel::filesChanged,   this, &Core::onFilesChanged);
     connect(model.get(), &DirectoryModel::loaded,         this, &Core::onModelLoaded);
+    connect(model.get(), &DirectoryModel::filesInserted,  this, &Core::onModelFilesInserted);
+    connect(model.get(), &DirectoryModel::scanFinished,   this, &Core::onModelScanFinished);
     connect(model.get(), &DirectoryModel::imageReady,     this, &Core::onModelItemReady);
     connect(model.get(), &DirectoryModel::imageUpdated,   this, &Core::onModelItemUpdated);
     connect(model.get(), &DirectoryModel::sortingChanged, this, &Core::onModelSortingChanged);
+    connect(model.get(), &DirectoryModel::orderChanged,   this, &Core::onModelOrderChanged);
     connect(model.get(), &DirectoryModel::loadFailed,     this, &Core::onLoadFailed);
+    connect(model.get(), &DirectoryModel::errorOccurred,  this, &Core::onModelError);
 
     connect(&slideshowTimer, &QTimer::timeout, this, &Core::nextImageSlideshow);
 
@@ -199,6 +203,7 @@ void Core::initActions() {
     connect(actionManager, &ActionManager::frameStep, mw, &MW::frameStep);
     connect(actionManager, &ActionManager::frameStepBack, mw, &MW::frameStepBack);
     connect(actionManager, &ActionManager::folderView, this, &Core::enableFolderView);
+    connect(actionManager, &ActionManager::filterFolderView, this, &Core::filterFolderView);
     connect(actionManager, &ActionManager::documentView, this, &Core::enableDocumentView);
     connect(actionManager, &ActionManager::toggleFolderView, this, &Core::toggleFolderView);
     connect(actionManager, &ActionManager::reloadImage, this, qOverload<>(&Core::reloadImage));
@@ -210,6 +215,8 @@ void Core::initActions() {
     connect(actionManager, &ActionManager::sortByName, this, &Core::sortByName);
     connect(actionManager, &ActionManager::sortByTime, this, &Core::sortByTime);
     connect(actionManager, &ActionManager::sortBySize, this, &Core::sortBySize);
+    connect(actionManager, &ActionManager::sortByDateTaken, this, &Core::sortByDateTaken);
+    connect(actionManager, &ActionManager::sortByDimensions, this, &Core::sortByDimensions);
     connect(actionManager, &ActionManager::toggleImageInfo, mw, &MW::toggleImageInfoOverlay);
     connect(actionManager, &ActionManager::toggleShuffle, this, &Core::toggleShuffle);
     connect(actionManager, &ActionManager::toggleScalingFilter, mw, &MW::toggleScalingFilter);
@@ -369,7 +376,8 @@ void Core::startSlideshow() {
         slideshow = true;
         mw->setLoopPlayback(false);
         enableDocumentView();
-        startSlideshowTimer();
+        // still loading otherwise; onModelItemReady() starts it then
+        startSlideshowTimer(model->cachedImage(state.currentFilePath));
         updateInfoString();
     }
 }
@@ -404,10 +412,28 @@ void Core::onModelLoaded() {
     folderViewPresenter.selectAndFocus(state.currentFilePath);
     if(shuffle)
         syncRandomizer();
+    // file count changes while scanning
+    if(model->isScanning())
+        updateInfoString();
+}
+
+// a scanned batch; the views only get the new rows
+void Core::onModelFilesInserted(QList<int> indexes) {
+    thumbPanelPresenter.onFilesInserted(indexes);
+    folderViewPresenter.onFilesInserted(indexes);
+    if(shuffle)
+        randomizer.insert(indexes);
+    updateInfoString();
+}
+
+void Core::onModelScanFinished() {
+    if(scanMessage)
+        scanMessage->deleteLater();
+    updateInfoString();
 }
 
 void Core::onDirectoryViewFileActivated(QString filePath) {
-    // we aren`t using async load so it won't flicker with empty view
+    // the previous image stays up until the new one is decoded
     mw->enableDocumentView();
     loadPath(filePath);
 }
@@ -505,6 +531,11 @@ void Core::enableFolderView() {
     mw->enableFolderView();
 }
 
+void Core::filterFolderView() {
+    stopSlideshow();
+    mw->focusFolderViewFilter();
+}
+
 void Core::enableDocumentView() {
     if(mw->currentViewMode() == MODE_DOCUMENT)
         return;
@@ -531,15 +562,17 @@ void Core::copyFileClipboard() {
     if(model->isEmpty())
         return;
 
-    QMimeData* mimeData = getMimeDataForImage(model->getImage(selectedPath()), TARGET_CLIPBOARD);
+    model->requestImage(selectedPath(), this, [this](std::shared_ptr<Image> img) {
+        QMimeData* mimeData = getMimeDataForImage(img, TARGET_CLIPBOARD);
 
-    // mimeData->text() should already contain an url
-    QByteArray gnomeFormat = QByteArray("copy\n").append(QUrl(mimeData->text()).toEncoded());
-    mimeData->setData("x-special/gnome-copied-files", gnomeFormat);
-    mimeData->setData("application/x-kde-cutselection", "0");
+        // mimeData->text() should already contain an url
+        QByteArray gnomeFormat = QByteArray("copy\n").append(QUrl(mimeData->text()).toEncoded());
+        mimeData->setData("x-special/gnome-copied-files", gnomeFormat);
+        mimeData->setData("application/x-kde-cutselection", "0");
 
-    QApplication::clipboard()->setMimeData(mimeData);
-    mw->showMessage(tr("File copied"));
+        QApplication::clipboard()->setMimeData(mimeData);
+        mw->showMessage(tr("File copied"));
+    });
 }
 
 void Core::copyPathClipboard() {
@@ -665,9 +698,13 @@ void Core::onDraggedOut(QList<QString> paths) {
     if(paths.isEmpty())
         return;
     QMimeData *mimeData;
-    // single selection, image
-    if(paths.count() == 1 && model->containsFile(paths.first())) {
-        mimeData = getMimeDataForImage(model->getImage(paths.last()), TARGET_DROP);
+    // single selection, image. only edited images need their data,
+    // and those are always cached; otherwise the url is enough
+    std::shared_ptr<Image> img;
+    if(paths.count() == 1 && model->containsFile(paths.first()))
+        img = model->cachedImage(paths.first());
+    if(img) {
+        mimeData = getMimeDataForImage(img, TARGET_DROP);
     } else { // multi-selection, or single directory. drag urls
         mimeData = new QMimeData();
         QList<QUrl> urlList;
@@ -740,8 +777,8 @@ FileOpResult Core::removeFile(QString filePath, bool trash) {
     bool reopen = false;
     std::shared_ptr<Image> img;
     if(state.currentFilePath == filePath) {
-        img = model->getImage(filePath);
-        if(img->type() == ANIMATED || img->type() == VIDEO) {
+        img = model->cachedImage(filePath);
+        if(img && (img->type() == ANIMATED || img->type() == VIDEO)) {
             mw->closeImage();
             reopen = true;
         }
@@ -754,6 +791,8 @@ FileOpResult Core::removeFile(QString filePath, bool trash) {
 }
 
 void Core::onFileRemoved(QString filePath, int index) {
+    if(shuffle)
+        randomizer.remove(index);
     // no files left
     if(model->isEmpty()) {
         mw->closeImage();
@@ -773,18 +812,47 @@ void Core::onFileRemoved(QString filePath, int index) {
     updateInfoString();
 }
 
-void Core::onFileRenamed(QString fromPath, int /*indexFrom*/, QString /*toPath*/, int indexTo) {
+void Core::onFileRenamed(QString fromPath, int indexFrom, QString /*toPath*/, int indexTo) {
+    if(shuffle)
+        randomizer.move(indexFrom, indexTo);
     if(state.currentFilePath == fromPath) {
         loadFileIndex(indexTo, true, settings->usePreloader());
     }
 }
 
 void Core::onFileAdded(QString filePath) {
-    Q_UNUSED(filePath)
+    if(shuffle)
+        randomizer.insert(model->indexOfFile(filePath));
     // update file count
     updateInfoString();
     if(model->fileCount() == 1 && state.currentFilePath == "")
-        loadFileIndex(0, false, settings->usePreloader());
+        loadFileIndex(0, true, settings->usePreloader());
+}
+
+// bulk changes: one view reload instead of per-item inserts / removals
+void Core::onFilesChanged(QStringList removedPaths, QList<int> removedAt, int previousCount) {
+    thumbPanelPresenter.reloadModel();
+    folderViewPresenter.reloadModel();
+    int removedIndex = removedPaths.indexOf(state.currentFilePath);
+    if(model->isEmpty()) {
+        mw->closeImage();
+        state.hasActiveImage = false;
+        state.currentFilePath = "";
+    } else if(removedIndex != -1) {
+        if(mw->currentViewMode() == MODE_DOCUMENT) {
+            loadFileIndex(qMin(removedAt.at(removedIndex), model->fileCount() - 1), true, settings->usePreloader());
+        } else {
+            state.hasActiveImage = false;
+            state.currentFilePath = "";
+        }
+    } else if(previousCount == 0 && state.currentFilePath == "") {
+        loadFileIndex(0, true, settings->usePreloader());
+    }
+    thumbPanelPresenter.selectAndFocus(state.currentFilePath);
+    folderViewPresenter.selectAndFocus(state.currentFilePath);
+    if(shuffle)
+        syncRandomizer();
+    updateInfoString();
 }
 
 // !! fixme
@@ -1009,8 +1077,7 @@ void Core::moveCurrentFile(QString destDirectory)
 
 	bool result = m_file_manager->moveTo(target, destDirectory);
 	if (result == false) {
-		guiSetImage(model->getImage(target));
-		updateInfoString();
+		this->reopenImage(target);
 		//outputError(result);
 	} else {
 		if (destDirectory != model->directoryPath()) {
@@ -1045,8 +1112,7 @@ void Core::moveCurrentDirectory(QString destDirectory)
 
 	bool result = m_file_manager->moveTo(target, destDirectory);
 	if (result == false) {
-		guiSetImage(model->getImage(last));
-		updateInfoString();
+		this->reopenImage(last);
 	} else {
 		model->removeDirEntry(target);
 
@@ -1061,6 +1127,18 @@ void Core::moveCurrentDirectory(QString destDirectory)
 	mw->repaint();
 }
 
+// shows the image again after closeCurrentImage()
+void Core::reopenImage(QString filePath)
+{
+	model->requestImage(filePath, this, [this, filePath](std::shared_ptr<Image> img) {
+		if (filePath != state.currentFilePath) {
+			return;
+		}
+		guiSetImage(img);
+		updateInfoString();
+	});
+}
+
 void Core::toggleCropPanel() {
     if(model->isEmpty())
         return;
@@ -1084,36 +1162,43 @@ void Core::requestSavePath() {
 void Core::showResizeDialog() {
     if(model->isEmpty())
         return;
-    auto img = model->getImage(selectedPath());
-    if(img)
-        mw->showResizeDialog(img->size());
+    model->requestImage(selectedPath(), this, [this](std::shared_ptr<Image> img) {
+        if(img)
+            mw->showResizeDialog(img->size());
+    });
 }
 
 // ---------------------------------------------------------------- image operations
 
-std::shared_ptr<ImageStatic> Core::getEditableImage(const QString &filePath) {
-    return std::dynamic_pointer_cast<ImageStatic>(model->getImage(filePath));
+// `callback` gets nullptr for anything that is not a static image
+void Core::getEditableImage(const QString &filePath, std::function<void(std::shared_ptr<ImageStatic>)> callback) {
+    model->requestImage(filePath, this, [callback](std::shared_ptr<Image> img) {
+        callback(std::dynamic_pointer_cast<ImageStatic>(img));
+    });
 }
 
+// cached images are edited right away, the rest as they finish loading
 template<typename... Args>
 void Core::edit_template(bool save, QString action, const std::function<QImage*(std::shared_ptr<const QImage>, Args...)>& editFunc, Args&&... as) {
     if(model->isEmpty())
         return;
     if(save && !mw->showConfirmation(action, tr("Perform action \"") + action + "\"? \n\n" + tr("Changes will be saved immediately.")))
         return;
+    std::function<QImage*(std::shared_ptr<const QImage>)> edit = std::bind(editFunc, std::placeholders::_1, std::forward<Args>(as)...);
     for(auto path : currentSelection()) {
-        auto img = getEditableImage(path);
-        if(!img)
-            continue;
-        img->setEditedImage(std::unique_ptr<const QImage>( editFunc(img->getImage(), std::forward<Args>(as)...) ));
-        model->updateImage(path, std::static_pointer_cast<Image>(img));
-        if(save) {
-            saveFile(path);
-            if(state.currentFilePath != path)
-                model->unload(path);
-        }
+        getEditableImage(path, [this, path, save, edit](std::shared_ptr<ImageStatic> img) {
+            if(!img)
+                return;
+            img->setEditedImage(std::unique_ptr<const QImage>( edit(img->getImage()) ));
+            model->updateImage(path, std::static_pointer_cast<Image>(img));
+            if(save) {
+                saveFile(path);
+                if(state.currentFilePath != path)
+                    model->unload(path);
+            }
+            updateInfoString();
+        });
     }
-    updateInfoString();
 }
 
 void Core::flipH() {
@@ -1141,6 +1226,7 @@ void Core::crop(QRect rect) {
 void Core::cropAndSave(QRect rect) {
     if(mw->currentViewMode() == MODE_FOLDERVIEW)
         return;
+    // the current image is always cached, so the edit is done by now
     edit_template(false, tr("Crop"), { ImageLib::cropped }, rect);
     saveFile(selectedPath());
     updateInfoString();
@@ -1184,7 +1270,8 @@ void Core::discardEdits() {
     if(model->isEmpty())
         return;
 
-    std::shared_ptr<Image> img = model->getImage(selectedPath());
+    // edits only exist on cached images
+    std::shared_ptr<Image> img = model->cachedImage(selectedPath());
     if(img && img->type() == STATIC) {
         auto imgStatic = dynamic_cast<ImageStatic *>(img.get());
         imgStatic->discardEditedImage();
@@ -1235,6 +1322,20 @@ void Core::sortBySize() {
     model->setSortingMode(mode);
 }
 
+void Core::sortByDateTaken() {
+    auto mode = SortingMode::SORT_DATE_TAKEN_ASC;
+    if(model->sortingMode() == mode)
+        mode = SortingMode::SORT_DATE_TAKEN_DESC;
+    model->setSortingMode(mode);
+}
+
+void Core::sortByDimensions() {
+    auto mode = SortingMode::SORT_DIMENSIONS_ASC;
+    if(model->sortingMode() == mode)
+        mode = SortingMode::SORT_DIMENSIONS_DESC;
+    model->setSortingMode(mode);
+}
+
 void Core::showRenameDialog() {
     if(model->isEmpty())
         return;
@@ -1245,14 +1346,18 @@ void Core::showRenameDialog() {
 void Core::runScript(const QString &scriptName) {
     if(model->isEmpty())
         return;
-    scriptManager->runScript(scriptName, model->getImage(selectedPath()));
+    model->requestImage(selectedPath(), this, [this, scriptName](std::shared_ptr<Image> img) {
+        if(img)
+            scriptManager->runScript(scriptName, img);
+    });
 }
 
 void Core::setWallpaper() {
     if(model->isEmpty() || selectedPath().isEmpty())
         return;
-    auto img = model->getImage(selectedPath());
-    if(img->type() != DocumentType::STATIC) {
+    // only the type is needed, no need to decode anything
+    DocumentInfo info(selectedPath());
+    if(info.type() != DocumentType::STATIC) {
         mw->showMessage("Set wallpaper: file not supported");
         return;
     }
@@ -1283,26 +1388,28 @@ void Core::setWallpaper() {
 void Core::print() {
     if(model->isEmpty())
         return;
-    PrintDialog p(mw);
-    auto img = model->getImage(selectedPath());
-    if(!img) {
-        mw->showError(tr("Could not open image"));
-        return;
-    }
-    if(img->type() != DocumentType::STATIC) {
-        mw->showError(tr("Can only print static images"));
-        return;
-    }
-    QString pdfPath = model->directoryPath() + "/" + img->baseName() + ".pdf";
-    p.setImage(img->getImage());
-    p.setOutputPath(pdfPath);
-    p.exec();
+    model->requestImage(selectedPath(), this, [this](std::shared_ptr<Image> img) {
+        if(!img) {
+            mw->showError(tr("Could not open image"));
+            return;
+        }
+        if(img->type() != DocumentType::STATIC) {
+            mw->showError(tr("Can only print static images"));
+            return;
+        }
+        PrintDialog p(mw);
+        QString pdfPath = model->directoryPath() + "/" + img->baseName() + ".pdf";
+        p.setImage(img->getImage());
+        p.setOutputPath(pdfPath);
+        p.exec();
+    });
 }
 
 void Core::scalingRequest(QSize size, ScalingFilter filter) {
     // filter out an unnecessary scale request at statup
     if(mw->isVisible() && state.hasActiveImage) {
-        std::shared_ptr<Image> forScale = model->getImage(state.currentFilePath);
+        // not cached yet means not shown yet; it gets scaled once it is
+        std::shared_ptr<Image> forScale = model->cachedImage(state.currentFilePath);
         if(forScale) {
             model->scaler->requestScaled(ScalerRequest(forScale, size, state.currentFilePath, filter));
         }
@@ -1371,7 +1478,8 @@ bool Core::loadPath(QString path) {
         qDebug() << "Could not open path: " << path;
         return false;
     }
-    if(!state.delayModel && !setDirectory(state.directoryPath))
+    // folder view can fill in while scanning
+    if(!state.delayModel && !setDirectory(state.directoryPath, fileInfo.isDir()))
         return false;
 
     // load file / folderview
@@ -1390,17 +1498,17 @@ bool Core::loadPath(QString path) {
             }
         }
         mw->enableDocumentView();
-        return loadFileIndex(index, false, settings->usePreloader());
+        return loadFileIndex(index, true, settings->usePreloader());
     } else {
         mw->enableFolderView();
         return true;
     }
 }
 
-bool Core::setDirectory(QString path) {
+bool Core::setDirectory(QString path, bool async) {
     if(model->directoryPath() != path) {
         this->reset();
-        if(!model->setDirectory(path)) {
+        if(!model->setDirectory(path, async)) {
             mw->showError(tr("Could not load folder: ") + path);
             return false;
         }
@@ -1413,23 +1521,36 @@ bool Core::loadFileIndex(int index, bool async, bool preload)
 {
 	if (!model)
 		return false;
-	auto entry = model->fileInfoAt(index);
-	if (entry.size() == 0) {
+	if (model->fileSizeAt(index) == 0) {
 		return false;
 	}
-	state.currentFilePath = entry.absoluteFilePath();
-	model->unloadExcept(entry.absoluteFilePath(), preload);
+	state.currentFilePath = model->filePathAt(index);
+	// no-op when we got here through the randomizer
+	if (shuffle)
+		randomizer.setCurrent(index);
+	QList<int> nearby;
+	if (preload)
+		nearby = preloadTargets(index);
+	model->unloadExcept(state.currentFilePath, nearby);
 	model->load(index, async);
-	if (preload) {
-		model->preload(index + 1);
-		model->preload(index - 1);
-	}
-	thumbPanelPresenter.selectAndFocus(entry.absoluteFilePath());
-	folderViewPresenter.selectAndFocus(entry.absoluteFilePath());
+	for (int i : nearby)
+		model->preload(i);
+	thumbPanelPresenter.selectAndFocus(state.currentFilePath);
+	folderViewPresenter.selectAndFocus(state.currentFilePath);
 	updateInfoString();
 	return true;
 }
 
+// files the user is likely to open next
+QList<int> Core::preloadTargets(int index) {
+    QList<int> targets;
+    if(shuffle)
+        targets << randomizer.peekNext() << randomizer.peekPrev();
+    else
+        targets << index + 1 << index - 1;
+    return targets;
+}
+
 void Core::loadParentDir() {
     if(model->directoryPath().isEmpty() || mw->currentViewMode() != MODE_FOLDERVIEW)
         return;
@@ -1445,38 +1566,22 @@ void Core::nextDirectory() {
     if(model->directoryPath().isEmpty() || mw->currentViewMode() != MODE_DOCUMENT)
         return;
     stopSlideshow();
-    QFileInfo currentDir(model->directoryPath());
-    QFileInfo parentDir(currentDir.absolutePath());
-    if(parentDir.exists() && parentDir.isReadable()) {
-        DirectoryManager dm;
-	    dm.setDirectoriesMode(true);
-        if(!dm.setDirectory(parentDir.absoluteFilePath(), false, false))
-            return;
-
-        QString next = dm.nextOfDir(model->directoryPath());
-        if(!next.isEmpty()) {
-            this->switchDirectory(next);
-        } else {
-            mw->showMessageDirectoryEnd();
-        }
+    QString next = model->resolveNextDirectory();
+    if(!next.isEmpty()) {
+        this->switchDirectory(next);
+    } else {
+        mw->showMessageDirectoryEnd();
     }
 }
 
 void Core::prevDirectory(bool selectLast) {
     if(model->directoryPath().isEmpty() || mw->currentViewMode() != MODE_DOCUMENT)
         return;
-    QFileInfo currentDir(model->directoryPath());
-    QFileInfo parentDir(currentDir.absolutePath());
-    if(parentDir.exists() && parentDir.isReadable()) {
-        DirectoryManager dm;
-				dm.setDirectoriesMode(true);
-	    dm.setDirectory(parentDir.absoluteFilePath(), false, false);
-        QString prev = dm.prevOfDir(model->directoryPath());
-        if(!prev.isEmpty()) {
-	        this->switchDirectory(prev, selectLast);
-        } else {
-            mw->showMessageDirectoryStart();
-        }
+    QString prev = model->resolvePrevDirectory();
+    if(!prev.isEmpty()) {
+        this->switchDirectory(prev, selectLast);
+    } else {
+        mw->showMessageDirectoryStart();
     }
 }
 
@@ -1490,7 +1595,7 @@ void Core::switchDirectory(const QString &path, bool select_last)
 
 	int count = model->fileCount();
 	if (count) {
-		loadFileIndex(select_last ? count - 1 : 0, false, true);
+		loadFileIndex(select_last ? count - 1 : 0, true, true);
 	}
 }
 
@@ -1503,7 +1608,7 @@ void Core::nextImage() {
         return;
     stopSlideshow();
     if(shuffle) {
-        loadFileIndex(randomizer.next(), true, false);
+        loadFileIndex(randomizer.next(), true, settings->usePreloader());
         return;
     }
     int newIndex = model->indexOfFile(state.currentFilePath) + 1;
@@ -1527,7 +1632,7 @@ void Core::prevImage() {
         return;
     stopSlideshow();
     if(shuffle) {
-        loadFileIndex(randomizer.prev(), true, false);
+        loadFileIndex(randomizer.prev(), true, settings->usePreloader());
         return;
     }
 
@@ -1551,7 +1656,7 @@ void Core::nextImageSlideshow() {
     if(model->isEmpty() || mw->currentViewMode() == MODE_FOLDERVIEW)
         return;
     if(shuffle) {
-        loadFileIndex(randomizer.next(), false, false);
+        loadFileIndex(randomizer.next(), true, true);
     } else {
         int newIndex = model->indexOfFile(state.currentFilePath) + 1;
         if(newIndex >= model->fileCount()) {
@@ -1563,15 +1668,16 @@ void Core::nextImageSlideshow() {
                 return;
             }
         }
-        loadFileIndex(newIndex, false, true);
+        loadFileIndex(newIndex, true, true);
     }
-    startSlideshowTimer();
+    // restarted from onModelItemReady() once the image is in
 }
 
-void Core::startSlideshowTimer() {
+void Core::startSlideshowTimer(std::shared_ptr<Image> img) {
     // start timer only for static images or single frame gifs
     // for proper gifs and video we get a playbackFinished() signal
-    auto img = model->getImage(state.currentFilePath);
+    if(!img)
+        return;
     if(img->type() == STATIC) {
         slideshowTimer.start();
     } else if(img->type() == ANIMATED) {
@@ -1599,8 +1705,21 @@ void Core::jumpToLast() {
 
 void Core::onLoadFailed(const QString &path) {
     mw->showMessage(tr("Load failed: ") + path);
-    if(path == state.currentFilePath)
+    if(path == state.currentFilePath) {
         mw->closeImage();
+        // list the directory anyway
+        if(state.delayModel) {
+            state.delayModel = false;
+            QTimer::singleShot(40, this, SLOT(modelDelayLoad()));
+        }
+        // skip it instead of stalling
+        if(slideshow)
+            slideshowTimer.start();
+    }
+}
+
+void Core::onModelError(const QString &message) {
+    mw->showMessage(message, 4000);
 }
 
 void Core::onModelItemReady(std::shared_ptr<Image> img, const QString &path) {
@@ -1608,24 +1727,38 @@ void Core::onModelItemReady(std::shared_ptr<Image> img, const QString &path) {
         state.currentImg = img;
         guiSetImage(img);
         updateInfoString();
+        if(slideshow)
+            startSlideshowTimer(img);
         if(state.delayModel) {
             this->showGui();
             state.delayModel = false;
             QTimer::singleShot(40, this, SLOT(modelDelayLoad()));
         }
-        model->unloadExcept(state.currentFilePath, settings->usePreloader());
+        QList<int> nearby;
+        if(settings->usePreloader())
+            nearby = preloadTargets(model->indexOfFile(path));
+        model->unloadExcept(state.currentFilePath, nearby);
     }
 }
 
+// the image is already shown, list the rest of the directory in the background
 void Core::modelDelayLoad()
 {
 	QDir dir(state.directoryPath);
-	QWidget *message = mw->addPermanentMessage(tr("Scanning directory...") + '\n' + dir.absolutePath());
-    model->setDirectory(dir.absolutePath());
-	message->deleteLater();
-   mw->setDirectoryPath(dir.absolutePath());
-    model->updateImage(state.currentFilePath, state.currentImg);
-		updateInfoString();
+	if (!model->setDirectory(dir.absolutePath(), true)) {
+		return;
+	}
+	if (model->isScanning()) {
+		if (scanMessage) {
+			scanMessage->deleteLater();
+		}
+		scanMessage = mw->addPermanentMessage(tr("Scanning directory...") + '\n' + dir.absolutePath());
+	}
+	// navigable right away, the scan skips it later
+	model->forceInsert(state.currentFilePath);
+	mw->setDirectoryPath(dir.absolutePath());
+	model->updateImage(state.currentFilePath, state.currentImg);
+	updateInfoString();
 }
 
 void Core::moveFilePathX(int index)
@@ -1650,17 +1783,30 @@ void Core::moveDirectoryPathX(int index)
 
 void Core::onModelItemUpdated(QString filePath) {
     if(filePath == state.currentFilePath) {
-        guiSetImage(model->getImage(filePath));
+        guiSetImage(model->cachedImage(filePath));
         updateInfoString();
     }
 }
 
 void Core::onModelSortingChanged(SortingMode mode) {
     mw->onSortingChanged(mode);
+    if(shuffle)
+        syncRandomizer();
+    thumbPanelPresenter.reloadModel();
+    thumbPanelPresenter.selectAndFocus(state.currentFilePath);
+    folderViewPresenter.reloadModel();
+    folderViewPresenter.selectAndFocus(state.currentFilePath);
+}
+
+// background metadata moved files around; no message, the shuffle order is kept
+void Core::onModelOrderChanged() {
     thumbPanelPresenter.reloadModel();
     thumbPanelPresenter.selectAndFocus(state.currentFilePath);
     folderViewPresenter.reloadModel();
     folderViewPresenter.selectAndFocus(state.currentFilePath);
+    if(shuffle)
+        randomizer.setCurrent(model->indexOfFile(state.currentFilePath));
+    updateInfoString();
 }
 
 void Core::guiSetImage(std::shared_ptr<Image> img) {
@@ -1674,7 +1820,7 @@ void Core::guiSetImage(std::shared_ptr<Image> img) {
         mw->showImage(img->getPixmap());
     } else if(type == ANIMATED) {
         auto animated = dynamic_cast<ImageAnimated *>(img.get());
-        mw->showAnimation(animated->getMovie());
+        mw->showAnimation(animated->getAnimation());
     } else if(type == VIDEO) {
         auto video = dynamic_cast<Video *>(img.get());
         // workaround for mpv. If we play video while mainwindow is hidden we get black screen.
@@ -1694,15 +1840,11 @@ void Core::updateInfoString()
 
 	info.index = index;
 	info.fileCount = model->fileCount();
-	info.file_info = index >= 0 ? model->fileInfoAt(index) : QFileInfo();
+	info.file_info = index >= 0 ? QFileInfo(model->filePathAt(index)) : QFileInfo();
 	info.slideshow = slideshow;
 	info.shuffle = shuffle;
 
-	if (index >= 0 && model->isLoaded(state.currentFilePath)) {
-		info.image = model->getImage(state.currentFilePath);
-	} else {
-		info.image = nullptr;
-	}
+	info.image = index >= 0 ? model->cachedImage(state.currentFilePath) : nullptr;
 
 	mw->updateInfo();
 }
@@ -8,6 +8,7 @@
 #include <QFileSystemModel>
 #include <QDesktopServices>
 #include <QTranslator>
+#include <QPointer>
 #include "appversion.h"
 #include "settings.h"
 #include "components/directorymodel.h"
@@ -67,11 +68,12 @@ private:
     std::shared_ptr<DirectoryModel> model;
 
     DirectoryPresenter thumbPanelPresenter, folderViewPresenter;
+    QPointer<QWidget> scanMessage;
 
     void rotateByDegrees(int degrees);
     void reset();
 		void clear();
-    bool setDirectory(QString path);
+    bool setDirectory(QString path, bool async = false);
 
     QDrag *mDrag;
     QMimeData *getMimeDataForImage(std::shared_ptr<Image> img, MimeDataTarget target);
@@ -79,6 +81,7 @@ private:
 
     Randomizer randomizer;
     void syncRandomizer();
+    QList<int> preloadTargets(int index);
 
     void attachModel(DirectoryModel *_model);
     QString selectedPath();
@@ -87,14 +90,14 @@ private:
 
 	QIV::FileManager *m_file_manager = nullptr;
 
-    void startSlideshowTimer();
+    void startSlideshowTimer(std::shared_ptr<Image> img);
     void startSlideshow();
     void stopSlideshow();
 
     bool saveFile(const QString &filePath, const QString &newPath);
     bool saveFile(const QString &filePath);
 
-    std::shared_ptr<ImageStatic> getEditableImage(const QString &filePath);
+    void getEditableImage(const QString &filePath, std::function<void(std::shared_ptr<ImageStatic>)> callback);
     QList<QString> currentSelection();
 
     template<typename... Args>
@@ -104,6 +107,7 @@ private:
     void doInteractiveMove(QString path, QString destDirectory, DialogResult &overwriteAllFiles);
 
 	void closeCurrentImage();
+	void reopenImage(QString filePath);
 	void switchDirectory(const QString &path, bool select_last = false);
 
 private slots:
@@ -116,7 +120,9 @@ private slots:
     void onModelItemReady(std::shared_ptr<Image>, const QString&);
     void onModelItemUpdated(QString fileName);
     void onModelSortingChanged(SortingMode mode);
+    void onModelOrderChanged();
     void onLoadFailed(const QString &path);
+    void onModelError(const QString &message);
     void rotateLeft();
     void rotateRight();
     void close();
@@ -133,6 +139,7 @@ private slots:
     void onFileRemoved(QString filePath, int index);
     void onFileRenamed(QString fromPath, int indexFrom, QString toPath, int indexTo);
     void onFileAdded(QString filePath);
+    void onFilesChanged(QStringList removedPaths, QList<int> removedAt, int previousCount);
     void onFileModified(QString filePath);
     void showResizeDialog();
     void resize(QSize size);
@@ -160,12 +167,16 @@ private slots:
     void sortByName();
     void sortByTime();
     void sortBySize();
+    void sortByDateTaken();
+    void sortByDimensions();
     void showRenameDialog();
     void onDraggedOut();
     void onDraggedOut(QList<QString> paths);
     void onDropIn(const QMimeData *mimeData, QObject* source);
     void toggleShuffle();
     void onModelLoaded();
+    void onModelFilesInserted(QList<int> indexes);
+    void onModelScanFinished();
     void outputError(const FileOpResult &error) const;
     void showOpenDialog();
     void showInDirectory();
@@ -173,6 +184,7 @@ private slots:
     bool loadFileIndex(int index, bool async, bool preload);
     void enableDocumentView();
     void enableFolderView();
+    void filterFolderView();
     void toggleFolderView();
     void toggleSlideshow();
     void onPlaybackFinished();
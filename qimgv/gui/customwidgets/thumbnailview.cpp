@@ -231,47 +231,19 @@ void ThumbnailView::populate(int newCount) {
     QElapsedTimer t;
     t.start();
     if(newCount >= 0) {
-        /* test this later
-        // reuse existing items
-        auto currentCount = thumbnails.count();
-        if(currentCount > newCount) {
-            qDebug() << this << "removing";
-            for(auto i = currentCount - 1; i >= newCount; i--) {
-                //removeItemFromLayout(i); // slow. is this needed?
-                delete thumbnails.takeLast();
-            }
-            // reset existing
-            QList<ThumbnailWidget*>::iterator i;
-            for(i = thumbnails.begin(); i != thumbnails.end(); ++i)
-                (*i)->reset();
-        } else if(currentCount <= newCount) {
-            // reset existing
-            QList<ThumbnailWidget*>::iterator i;
-            for(i = thumbnails.begin(); i != thumbnails.end(); ++i)
-                (*i)->reset();
-            qDebug() << this << "adding";
-            for(auto i = currentCount; i < newCount; i++) {
-                ThumbnailWidget *widget = createThumbnailWidget();
-                widget->setThumbnailSize(mThumbnailSize);
-                thumbnails.append(widget);
-                addItemToLayout(widget, i);
-            }
+        // reuse what is there; only the difference is created or deleted.
+        // Matters when the count changes by little on every keystroke (filter)
+        while(thumbnails.count() > newCount) {
+            removeItemFromLayout(thumbnails.count() - 1);
+            delete thumbnails.takeLast();
         }
-        */
-
-        if(newCount == thumbnails.count()) {
-            QList<ThumbnailWidget*>::iterator i;
-            for (i = thumbnails.begin(); i != thumbnails.end(); ++i) {
-                (*i)->reset();
-            }
-        } else {
-            removeAll();
-            for(int i = 0; i < newCount; i++) {
-                ThumbnailWidget *widget = createThumbnailWidget();
-                widget->setThumbnailSize(mThumbnailSize);
-                thumbnails.append(widget);
-                addItemToLayout(widget, i);
-            }
+        for(auto widget : thumbnails)
+            widget->reset();
+        for(int i = thumbnails.count(); i < newCount; i++) {
+            ThumbnailWidget *widget = createThumbnailWidget();
+            widget->setThumbnailSize(mThumbnailSize);
+            thumbnails.append(widget);
+            addItemToLayout(widget, i);
         }
     }
     updateLayout();
@@ -307,6 +279,27 @@ void ThumbnailView::insertItem(int index) {
     loadVisibleThumbnails();
 }
 
+// same as insertItem() for each index, with a single layout pass
+void ThumbnailView::insertItems(QList<int> indexes) {
+    if(indexes.isEmpty())
+        return;
+    auto newSelection = mSelection;
+    for(int index : indexes) {
+        ThumbnailWidget *widget = createThumbnailWidget();
+        thumbnails.insert(index, widget);
+        addItemToLayout(widget, index);
+        for(int i=0; i < newSelection.count(); i++) {
+            if(index <= newSelection[i])
+                newSelection[i]++;
+        }
+    }
+    updateLayout();
+    fitSceneToContents();
+    select(newSelection);
+    updateScrollbarIndicator();
+    loadVisibleThumbnails();
+}
+
 void ThumbnailView::removeItem(int index) {
     if(checkRange(index)) {
         auto newSelection = mSelection;
@@ -381,13 +374,18 @@ void ThumbnailView::loadVisibleThumbnails() {
             offRectFront = QRectF(visRect.left(), visRect.bottom(),
                                   visRect.width(), offscreenPreloadArea);
         }
+        // priority order: visible items in scroll direction,
+        // then the offscreen area we are scrolling into, then the one behind
         QList<QGraphicsItem *>visibleItems;
-        if(lastScrollDirection == SCROLL_FORWARDS)
+        if(lastScrollDirection == SCROLL_FORWARDS) {
             visibleItems = scene.items(visRect, Qt::IntersectsItemBoundingRect, Qt::AscendingOrder);
-        else
+            visibleItems.append(scene.items(offRectFront, Qt::IntersectsItemBoundingRect, Qt::AscendingOrder));
+            visibleItems.append(scene.items(offRectBack,  Qt::IntersectsItemBoundingRect, Qt::DescendingOrder));
+        } else {
             visibleItems = scene.items(visRect, Qt::IntersectsItemBoundingRect, Qt::DescendingOrder);
-        visibleItems.append(scene.items(offRectBack,  Qt::IntersectsItemBoundingRect, Qt::DescendingOrder));
-        visibleItems.append(scene.items(offRectFront, Qt::IntersectsItemBoundingRect, Qt::AscendingOrder));
+            visibleItems.append(scene.items(offRectBack,  Qt::IntersectsItemBoundingRect, Qt::DescendingOrder));
+            visibleItems.append(scene.items(offRectFront, Qt::IntersectsItemBoundingRect, Qt::AscendingOrder));
+        }
         // select
         QList<int> loadList;
         for(int i = 0; i < visibleItems.count(); i++) {
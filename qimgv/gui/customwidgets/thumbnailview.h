@@ -62,6 +62,7 @@ public slots:
     virtual void populate(int count) override;
     virtual void setThumbnail(int pos, std::shared_ptr<Thumbnail> thumb) override;
     virtual void insertItem(int index) override;
+    virtual void insertItems(QList<int> indexes) override;
     virtual void removeItem(int index) override;
     virtual void reloadItem(int index) override;
     virtual void setDragHover(int index) override;
@@ -81,6 +81,8 @@ FolderView::FolderView(QWidget *parent) :
 
     connect(ui->zoomSlider, &QSlider::valueChanged, this, &FolderView::onZoomSliderValueChanged);
     connect(ui->sortingComboBox, qOverload<int>(&QComboBox::currentIndexChanged), this, &FolderView::onSortingSelected);
+    connect(ui->filterLineEdit, &QLineEdit::textChanged, this, &FolderView::filterChanged);
+    ui->filterLineEdit->installEventFilter(this);
     connect(ui->togglePlacesPanelButton, &ActionButton::toggled, this, &FolderView::onPlacesPanelButtonChecked);
 
     connect(ui->optionsPopupButton, &IconButton::toggled, this, &FolderView::onOptionsPopupButtonToggled);
@@ -206,6 +208,35 @@ void FolderView::onSortingChanged(SortingMode mode) {
     ui->sortingComboBox->blockSignals(false);
 }
 
+void FolderView::focusFilter() {
+    ui->filterLineEdit->setFocus();
+    ui->filterLineEdit->selectAll();
+}
+
+// keep esc / arrows from reaching the main window shortcuts while typing
+bool FolderView::eventFilter(QObject *object, QEvent *event) {
+    if(object == ui->filterLineEdit && event->type() == QEvent::KeyPress) {
+        QKeyEvent *keyEvent = static_cast<QKeyEvent*>(event);
+        switch(keyEvent->key()) {
+        case Qt::Key_Escape:
+            // first press clears, second one leaves the box
+            if(!ui->filterLineEdit->text().isEmpty())
+                ui->filterLineEdit->clear();
+            else
+                ui->thumbnailGrid->setFocus();
+            return true;
+        case Qt::Key_Return:
+        case Qt::Key_Enter:
+        case Qt::Key_Down:
+            ui->thumbnailGrid->setFocus();
+            return true;
+        default:
+            break;
+        }
+    }
+    return FloatingWidgetContainer::eventFilter(object, event);
+}
+
 FolderView::~FolderView() {
     delete ui;
 }
@@ -287,6 +318,10 @@ void FolderView::setDirectoryPath(QString path) {
     }
 #endif
     ui->pathLabel->setText(path);
+    // the presenter drops the filter on directory change
+    ui->filterLineEdit->blockSignals(true);
+    ui->filterLineEdit->clear();
+    ui->filterLineEdit->blockSignals(false);
 
     if(ui->dirTreeView->currentIndex().data() == path)
         return;
@@ -342,6 +377,10 @@ void FolderView::insertItem(int index) {
     ui->thumbnailGrid->insertItem(index);
 }
 
+void FolderView::insertItems(QList<int> indexes) {
+    ui->thumbnailGrid->insertItems(indexes);
+}
+
 void FolderView::removeItem(int index) {
     ui->thumbnailGrid->removeItem(index);
 }
@@ -38,19 +38,21 @@ public slots:
     virtual void focusOnSelection() override;
     virtual void setDirectoryPath(QString path) override;
     virtual void insertItem(int index) override;
+    virtual void insertItems(QList<int> indexes) override;
     virtual void removeItem(int index) override;
     virtual void reloadItem(int index) override;
     virtual void setDragHover(int) override;
     void addItem();
     void onFullscreenModeChanged(bool mode);
     void onSortingChanged(SortingMode mode);
-
+    void focusFilter();
 
 protected:
     void wheelEvent(QWheelEvent *event) override;
     void focusInEvent(QFocusEvent *event) override;
     void paintEvent(QPaintEvent *) override;
     void resizeEvent(QResizeEvent *event) override;
+    bool eventFilter(QObject *object, QEvent *event) override;
 
 protected slots:
     void onThumbnailSizeChanged(int newSize);
@@ -62,6 +64,7 @@ signals:
     void draggedOut() override;
     void draggedToBookmarks(QList<int>) override;
     void sortingSelected(SortingMode);
+    void filterChanged(QString text);
     void directorySelected(QString path);
     void showFoldersChanged(bool mode);
     void copyUrlsRequested(QList<QString>, QString path);
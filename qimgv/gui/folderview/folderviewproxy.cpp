@@ -23,6 +23,7 @@ void FolderViewProxy::init() {
     connect(folderView.get(), &FolderView::itemActivated, this, &FolderViewProxy::itemActivated);
     connect(folderView.get(), &FolderView::thumbnailsRequested, this, &FolderViewProxy::thumbnailsRequested);
     connect(folderView.get(), &FolderView::sortingSelected, this, &FolderViewProxy::sortingSelected);
+    connect(folderView.get(), &FolderView::filterChanged, this, &FolderViewProxy::filterChanged);
     connect(folderView.get(), &FolderView::showFoldersChanged, this, &FolderViewProxy::showFoldersChanged);
     connect(folderView.get(), &FolderView::directorySelected, this, &FolderViewProxy::directorySelected);
     connect(folderView.get(), &FolderView::draggedOut, this, &FolderViewProxy::draggedOut);
@@ -116,6 +117,14 @@ void FolderViewProxy::insertItem(int index) {
     }
 }
 
+void FolderViewProxy::insertItems(QList<int> indexes) {
+    if(folderView) {
+        folderView->insertItems(indexes);
+    } else {
+        stateBuf.itemCount += indexes.count();
+    }
+}
+
 void FolderViewProxy::removeItem(int index) {
     if(folderView) {
         folderView->removeItem(index);
@@ -165,6 +174,11 @@ void FolderViewProxy::onSortingChanged(SortingMode mode) {
     }
 }
 
+void FolderViewProxy::focusFilter() {
+    init();
+    folderView->focusFilter();
+}
+
 void FolderViewProxy::showEvent(QShowEvent *event) {
     init();
     QWidget::showEvent(event);
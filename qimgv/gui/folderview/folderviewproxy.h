@@ -28,12 +28,14 @@ public slots:
     virtual void focusOnSelection() override;
     virtual void setDirectoryPath(QString path) override;
     virtual void insertItem(int index) override;
+    virtual void insertItems(QList<int> indexes) override;
     virtual void removeItem(int index) override;
     virtual void reloadItem(int index) override;
     virtual void setDragHover(int) override;
     void addItem();
     void onFullscreenModeChanged(bool mode);
     void onSortingChanged(SortingMode mode);
+    void focusFilter();
 
 protected:
     void showEvent(QShowEvent *event) override;
@@ -44,6 +46,7 @@ signals:
     void draggedOut() override;
     void draggedToBookmarks(QList<int>) override;
     void sortingSelected(SortingMode);
+    void filterChanged(QString);
     void showFoldersChanged(bool mode);
     void directorySelected(QString);
     void copyUrlsRequested(QList<QString>, QString path);
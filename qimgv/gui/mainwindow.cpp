@@ -64,6 +64,7 @@ void MW::setupUi() {
     docWidget.reset(new DocumentWidget(viewerWidget, infoBarWindowed));
     folderView.reset(new FolderViewProxy(this));
     connect(folderView.get(), &FolderViewProxy::sortingSelected, this, &MW::sortingSelected);
+    connect(folderView.get(), &FolderViewProxy::filterChanged, this, &MW::folderViewFilterChanged);
     connect(folderView.get(), &FolderViewProxy::directorySelected, this, &MW::opened);
     connect(folderView.get(), &FolderViewProxy::copyUrlsRequested, this, &MW::copyUrlsRequested);
     connect(folderView.get(), &FolderViewProxy::moveUrlsRequested, this, &MW::moveUrlsRequested);
@@ -81,6 +82,7 @@ void MW::setupUi() {
     connect(viewerWidget.get(), &ViewerWidget::scalingRequested, this, &MW::scalingRequested);
     connect(viewerWidget.get(), &ViewerWidget::draggedOut, this, qOverload<>(&MW::draggedOut));
     connect(viewerWidget.get(), &ViewerWidget::playbackFinished, this, &MW::playbackFinished);
+    connect(viewerWidget.get(), &ViewerWidget::playbackError, this, &MW::showError);
     connect(viewerWidget.get(), &ViewerWidget::showScriptSettings, this, &MW::showScriptSettings);
     connect(this, &MW::zoomIn,        viewerWidget.get(), &ViewerWidget::zoomIn);
     connect(this, &MW::zoomOut,       viewerWidget.get(), &ViewerWidget::zoomOut);
@@ -166,6 +168,12 @@ void MW::enableFolderView() {
     onInfoUpdated();
 }
 
+void MW::focusFolderViewFilter() {
+    if(centralWidget->currentViewMode() != ViewMode::MODE_FOLDERVIEW)
+        enableFolderView();
+    folderView->focusFilter();
+}
+
 void MW::enableDocumentView() {
     centralWidget->showDocumentView();
     onInfoUpdated();
@@ -249,10 +257,10 @@ void MW::showImage(std::unique_ptr<QPixmap> pixmap) {
     updateCropPanelData();
 }
 
-void MW::showAnimation(std::shared_ptr<QMovie> movie) {
+void MW::showAnimation(std::shared_ptr<AnimationDecoder> animation) {
     if(settings->autoResizeWindow())
-        preShowResize(movie->frameRect().size());
-    viewerWidget->showAnimation(movie);
+        preShowResize(animation->size());
+    viewerWidget->showAnimation(animation);
     updateCropPanelData();
 }
 
@@ -276,6 +284,13 @@ void MW::onSortingChanged(SortingMode mode) {
             case SortingMode::SORT_TIME_DESC: showMessage("Sorting: By Time (desc.)");      break;
             case SortingMode::SORT_SIZE_ASC:      showMessage("Sorting: By File Size");         break;
             case SortingMode::SORT_SIZE_DESC: showMessage("Sorting: By File Size (desc.)"); break;
+            case SortingMode::SORT_DATE_TAKEN_ASC:  showMessage("Sorting: By Date Taken");         break;
+            case SortingMode::SORT_DATE_TAKEN_DESC: showMessage("Sorting: By Date Taken (desc.)"); break;
+            case SortingMode::SORT_DIMENSIONS_ASC:  showMessage("Sorting: By Dimensions");         break;
+            case SortingMode::SORT_DIMENSIONS_DESC: showMessage("Sorting: By Dimensions (desc.)"); break;
+            case SortingMode::SORT_CAMERA_ASC:      showMessage("Sorting: By Camera");             break;
+            case SortingMode::SORT_CAMERA_DESC:     showMessage("Sorting: By Camera (desc.)");     break;
+            case SortingMode::SORT_MODE_COUNT:  break;
         }
     }
 }
@@ -64,7 +64,7 @@ public:
     bool isCropPanelActive();
     void onScalingFinished(std::unique_ptr<QPixmap>scaled);
     void showImage(std::unique_ptr<QPixmap> pixmap);
-    void showAnimation(std::shared_ptr<QMovie> movie);
+    void showAnimation(std::shared_ptr<AnimationDecoder> animation);
     void showVideo(QString file);
 
     void setExifInfo(QMap<QString, QString>);
@@ -176,6 +176,7 @@ signals:
     void saveRequested();
     void saveAsRequested(QString);
     void sortingSelected(SortingMode);
+    void folderViewFilterChanged(QString);
 
     // viewerWidget
     void scalingRequested(QSize, ScalingFilter);
@@ -209,6 +210,7 @@ public slots:
     void hideCropPanel();
     void toggleFolderView();
     void enableFolderView();
+    void focusFolderViewFilter();
     void enableDocumentView();
     void showOpenDialog(QString path);
     void showSaveDialog(QString filePath);
@@ -98,6 +98,14 @@ void ThumbnailStripProxy::insertItem(int index) {
     }
 }
 
+void ThumbnailStripProxy::insertItems(QList<int> indexes) {
+    if(thumbnailStrip) {
+        thumbnailStrip->insertItems(indexes);
+    } else {
+        stateBuf.itemCount += indexes.count();
+    }
+}
+
 void ThumbnailStripProxy::removeItem(int index) {
     if(thumbnailStrip) {
         thumbnailStrip->removeItem(index);
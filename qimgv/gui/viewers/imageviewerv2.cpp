@@ -3,7 +3,14 @@
 ImageViewerV2::ImageViewerV2(QWidget *parent) : QGraphicsView(parent),
     pixmap(nullptr),
     pixmapScaled(nullptr),
-    movie(nullptr),
+    animation(nullptr),
+    prefetcher(nullptr),
+    currentFrame(0),
+    currentDelay(0),
+    waitingForFrame(false),
+    seekPending(false),
+    frameDeadline(0),
+    originalStale(false),
     transparencyGrid(false),
     expandImage(false),
     smoothAnimatedImages(true),
@@ -138,25 +145,26 @@ void ImageViewerV2::onFullscreenModeChanged(bool mode) {
 }
 
 void ImageViewerV2::startAnimation() {
-    if(movie && movie->frameCount() > 1) {
+    if(animation && (animation->frameCount() > 1 || !animation->frameCountKnown())) {
         stopAnimation();
         emit animationPaused(false);
-        //movie->jumpToFrame(0);
-        //emit frameChanged(0);
-        animationTimer->start(movie->nextFrameDelay());
+        animationClock.restart();
+        frameDeadline = currentDelay;
+        animationTimer->start(currentDelay);
     }
 }
 
 void ImageViewerV2::stopAnimation() {
-    if(movie) {
+    if(animation) {
         emit animationPaused(true);
         animationTimer->stop();
+        waitingForFrame = false;
     }
 }
 
 void ImageViewerV2::pauseResume() {
-    if(movie) {
-        if(animationTimer->isActive())
+    if(animation) {
+        if(animationTimer->isActive() || waitingForFrame)
             stopAnimation();
         else
             startAnimation();
@@ -171,76 +179,144 @@ void ImageViewerV2::disableDrags() {
     dragsEnabled = false;
 }
 
+// the count may still be unknown on the first pass;
+// then the end shows up as a failed read
+bool ImageViewerV2::isLastFrame(int frame) const {
+    return animation->frameCountKnown() && frame >= animation->frameCount() - 1;
+}
+
+// Frames come decoded from the prefetcher; this only swaps them in.
+// The schedule follows the frame delays, not the timer, so a late frame
+// doesn't push the rest of the animation back
 void ImageViewerV2::onAnimationTimer() {
-    if(!movie)
+    if(!animation)
         return;
-    if(movie->currentFrameNumber() == movie->frameCount() - 1) {
-        // last frame
-        if(!loopPlayback) {
-            emit animationPaused(true);
-            emit playbackFinished();
-            return;
-        } else {
-            movie->jumpToFrame(0);
-        }
-    } else {
-        if(!movie->jumpToNextFrame()) {
-            qDebug() << "[Error] QMovie:" << movie->lastErrorString();
-            this->stopAnimation();
+    int next = prefetcher->nextIndex();
+    if(next == -1) {
+        // decoder fell behind; onFrameReady() picks it up
+        waitingForFrame = true;
+        return;
+    }
+    waitingForFrame = false;
+    if(next == 0 && currentFrame != 0 && !loopPlayback) {
+        emit animationPaused(true);
+        emit playbackFinished();
+        return;
+    }
+    AnimationFrame frame;
+    prefetcher->take(frame);
+    seekPending = false;
+    setAnimationFrame(frame);
+    frameDeadline += currentDelay;
+    qint64 wait = frameDeadline - animationClock.elapsed();
+    // too far behind to catch up; start the schedule over
+    if(wait < -currentDelay) {
+        frameDeadline = animationClock.elapsed() + currentDelay;
+        wait = currentDelay;
+    }
+    animationTimer->start(static_cast<int>(qMax(wait, qint64(0))));
+}
+
+// signals from a discarded prefetcher may still be queued; sender() filters them out
+void ImageViewerV2::onFrameReady() {
+    if(!prefetcher || sender() != prefetcher.get())
+        return;
+    if(seekPending) {
+        AnimationFrame frame;
+        if(!prefetcher->take(frame))
             return;
+        seekPending = false;
+        setAnimationFrame(frame);
+        if(waitingForFrame) {
+            // the timer ran dry while the seek was decoding
+            waitingForFrame = false;
+            frameDeadline = animationClock.elapsed() + currentDelay;
+            animationTimer->start(qMax(currentDelay, 0));
         }
+    } else if(waitingForFrame) {
+        frameDeadline = animationClock.elapsed();
+        onAnimationTimer();
     }
-    emit frameChanged(movie->currentFrameNumber());
-    std::unique_ptr<QPixmap> newFrame(new QPixmap());
-    *newFrame = movie->currentPixmap();
-    updatePixmap(std::move(newFrame));
-    animationTimer->start(movie->nextFrameDelay());
+}
+
+void ImageViewerV2::onFrameCountChanged(int count) {
+    if(sender() != prefetcher.get())
+        return;
+    emit durationChanged(count);
+}
+
+void ImageViewerV2::onAnimationFailed() {
+    if(!prefetcher || sender() != prefetcher.get())
+        return;
+    stopAnimation();
+    seekPending = false;
+    emit playbackError(tr("Could not decode the animation"));
 }
 
 void ImageViewerV2::nextFrame() {
-    if(!movie) {
+    if(!animation)
         return;
-    } else if(movie->currentFrameNumber() == movie->frameCount() - 1) {
-        showAnimationFrame(0);
-    } else {
-        showAnimationFrame(movie->currentFrameNumber() + 1);
-    }
+    showAnimationFrame(isLastFrame(currentFrame) ? 0 : currentFrame + 1);
 }
 
 void ImageViewerV2::prevFrame() {
-    if(!movie) {
+    if(!animation) {
         return;
-    } else if(movie->currentFrameNumber() == 0) {
-        showAnimationFrame(movie->frameCount() - 1);
+    } else if(currentFrame == 0) {
+        showAnimationFrame(animation->frameCount() - 1);
     } else {
-        showAnimationFrame(movie->currentFrameNumber() - 1);
+        showAnimationFrame(currentFrame - 1);
     }
 }
 
+// Cached frames are shown right away, anything else is decoded off the GUI thread
+// and shown when ready. Playback continues from here either way
 bool ImageViewerV2::showAnimationFrame(int frame) {
-    if(!movie || frame < 0 || frame >= movie->frameCount())
+    if(!animation || frame < 0 || (animation->frameCountKnown() && frame >= animation->frameCount()))
         return false;
-    if(movie->currentFrameNumber() == frame)
+    if(frame == currentFrame && pixmap && !seekPending)
         return true;
-    // at the first glance this may seem retarded
-    // because it is
-    // unfortunately i dont see a *better* way to do seeking with QMovie
-    // QMovie::CacheAll is buggy and memory inefficient
-    if(frame < movie->currentFrameNumber())
-        movie->jumpToFrame(0);
-    while(frame != movie->currentFrameNumber()) {
-        if(!movie->jumpToNextFrame()) {
-            qDebug() << "[Error] QMovie:" << movie->lastErrorString();
-            break;
-        }
+    AnimationFrame cached;
+    // scaled frames are made on the worker, so only take the shortcut without them
+    if(!pixmapItemScaled.isVisible() && animation->cachedFrame(frame, cached.image)) {
+        seekPending = false;
+        cached.index = frame;
+        cached.delay = animation->frameDelay(frame);
+        setAnimationFrame(cached);
+        prefetcher->seek(frame + 1);
+    } else {
+        seekPending = true;
+        prefetcher->seek(frame);
     }
-    emit frameChanged(movie->currentFrameNumber());
-    std::unique_ptr<QPixmap> newFrame(new QPixmap());
-    *newFrame = movie->currentPixmap();
-    updatePixmap(std::move(newFrame));
     return true;
 }
 
+void ImageViewerV2::setAnimationFrame(const AnimationFrame &frame) {
+    currentFrame = frame.index;
+    currentDelay = frame.delay;
+    currentFrameImage = frame.image;
+    emit frameChanged(currentFrame);
+    // zoom may have changed while it was in the ring
+    if(!frame.scaled.isNull() && frame.scaled.size() == scaledSizeR() * dpr) {
+        // the full size one is hidden, skip converting it
+        originalStale = true;
+        pixmapScaled.reset(new QPixmap(QPixmap::fromImage(frame.scaled)));
+        pixmapScaled->setDevicePixelRatio(dpr);
+        pixmapItemScaled.setPixmap(*pixmapScaled);
+        pixmapItem.hide();
+        pixmapItemScaled.show();
+        return;
+    }
+    originalStale = false;
+    std::unique_ptr<QPixmap> newFrame(new QPixmap(QPixmap::fromImage(frame.image)));
+    updatePixmap(std::move(newFrame));
+    if(pixmapItemScaled.isVisible()) {
+        pixmapItemScaled.hide();
+        pixmapItemScaled.setPixmap(QPixmap());
+        pixmapScaled.reset(nullptr);
+    }
+}
+
 void ImageViewerV2::updatePixmap(std::unique_ptr<QPixmap> newPixmap) {
     pixmap = std::move(newPixmap);
     pixmap->setDevicePixelRatio(dpr);
@@ -249,18 +325,31 @@ void ImageViewerV2::updatePixmap(std::unique_ptr<QPixmap> newPixmap) {
     pixmapItem.update();
 }
 
-void ImageViewerV2::showAnimation(std::shared_ptr<QMovie> _movie) {
-    if(_movie && _movie->isValid()) {
+void ImageViewerV2::showAnimation(std::shared_ptr<AnimationDecoder> _animation) {
+    if(_animation && _animation->isValid()) {
         reset();
-        movie = _movie;
-        movie->jumpToFrame(0);
+        animation = _animation;
         Qt::TransformationMode mode = smoothAnimatedImages ? Qt::SmoothTransformation : Qt::FastTransformation;
         pixmapItem.setTransformationMode(mode);
-        std::unique_ptr<QPixmap> newFrame(new QPixmap());
-        *newFrame = movie->currentPixmap();
-        updatePixmap(std::move(newFrame));
-        emit durationChanged(movie->frameCount());
-        emit frameChanged(0);
+        // usually read on the loader thread already; if not, a blank canvas
+        // stands in until the worker delivers it
+        AnimationFrame firstFrame;
+        firstFrame.index = 0;
+        bool cached = animation->cachedFrame(0, firstFrame.image);
+        if(cached) {
+            firstFrame.delay = animation->frameDelay(0);
+        } else {
+            firstFrame.image = QImage(animation->size(), QImage::Format_ARGB32_Premultiplied);
+            firstFrame.image.fill(Qt::transparent);
+        }
+        setAnimationFrame(firstFrame);
+        emit durationChanged(animation->frameCount());
+        prefetcher.reset(new AnimationPrefetcher(animation));
+        connect(prefetcher.get(), &AnimationPrefetcher::frameReady, this, &ImageViewerV2::onFrameReady);
+        connect(prefetcher.get(), &AnimationPrefetcher::frameCountChanged, this, &ImageViewerV2::onFrameCountChanged);
+        connect(prefetcher.get(), &AnimationPrefetcher::failed, this, &ImageViewerV2::onAnimationFailed);
+        seekPending = !cached;
+        prefetcher->seek(cached ? 1 : 0);
 
         updateMinScale();
         if(!keepFitMode || imageFitMode == FIT_FREE)
@@ -275,6 +364,7 @@ void ImageViewerV2::showAnimation(std::shared_ptr<QMovie> _movie) {
                 applySavedViewportPos();
         }
         startAnimation();
+        requestScaling();
     }
 }
 
@@ -319,7 +409,14 @@ void ImageViewerV2::reset() {
     pixmapItem.setOffset(10000,10000);
     pixmap.reset();
     stopAnimation();
-		movie = nullptr;
+    // the worker may be in the middle of a frame; don't wait for it here
+    if(prefetcher)
+        prefetcher.release()->discard();
+		animation = nullptr;
+    currentFrame = 0;
+    seekPending = false;
+    currentFrameImage = QImage();
+    originalStale = false;
     centerOn(10000,10000);
     // when this view is not in focus this it won't update the background
     // so we force it here
@@ -331,7 +428,7 @@ void ImageViewerV2::closeImage() {
 }
 
 void ImageViewerV2::setScaledPixmap(std::unique_ptr<QPixmap> newFrame) {
-    if(!movie && newFrame->size() != scaledSizeR() * dpr)
+    if(!animation && newFrame->size() != scaledSizeR() * dpr)
         return;
 
     pixmapScaled = std::move(newFrame);
@@ -378,7 +475,7 @@ void ImageViewerV2::setScalingFilter(ScalingFilter filter) {
 }
 
 void ImageViewerV2::setLoopPlayback(bool mode) {
-    if(movie && mode && loopPlayback != mode)
+    if(animation && mode && loopPlayback != mode)
         startAnimation();
     loopPlayback = mode;
 }
@@ -405,7 +502,7 @@ Qt::TransformationMode ImageViewerV2::selectTransformationMode() {
     Qt::TransformationMode mode = Qt::SmoothTransformation;
     if(forceFastScale) {
         mode = Qt::FastTransformation;
-    } else if(movie) {
+    } else if(animation) {
         if(!smoothAnimatedImages || (pixmapItem.scale() > 1.0f && !smoothUpscaling))
             mode = Qt::FastTransformation;
     } else {
@@ -434,7 +531,11 @@ void ImageViewerV2::hide() {
 }
 
 void ImageViewerV2::requestScaling() {
-    if(!pixmap || pixmapItem.scale() == 1.0f || movie)
+    if(animation) {
+        requestAnimationScaling();
+        return;
+    }
+    if(!pixmap || pixmapItem.scale() == 1.0f)
         return;
     if(scaleTimer->isActive())
         scaleTimer->stop();
@@ -444,6 +545,30 @@ void ImageViewerV2::requestScaling() {
         emit scalingRequested(scaledSizeR() * dpr, mScalingFilter);
 }
 
+// Same rules as for static images, but the frames are resampled by the prefetcher
+void ImageViewerV2::requestAnimationScaling() {
+    if(!prefetcher || !pixmap)
+        return;
+    if(scaleTimer->isActive())
+        scaleTimer->stop();
+    QSize size;
+    if(smoothAnimatedImages && mScalingFilter != QI_FILTER_NEAREST &&
+       pixmapItem.scale() != 1.0f && currentScale() < FAST_SCALE_THRESHOLD)
+    {
+        size = scaledSizeR() * dpr;
+    }
+    prefetcher->setScaling(size, mScalingFilter);
+    if(size.isEmpty()) {
+        swapToOriginalPixmap();
+    } else if(!animationTimer->isActive() && !waitingForFrame &&
+              (!pixmapItemScaled.isVisible() || pixmapScaled->size() != size))
+    {
+        // paused: redo the frame on screen
+        seekPending = true;
+        prefetcher->seek(currentFrame);
+    }
+}
+
 bool ImageViewerV2::imageFits() const {
     if(!pixmap)
         return true;
@@ -473,7 +598,7 @@ QWidget *ImageViewerV2::widget() {
 }
 
 bool ImageViewerV2::hasAnimation() const {
-    return (movie != nullptr);
+    return (animation != nullptr);
 }
 
 //  Right button zooming / dragging logic
@@ -985,6 +1110,10 @@ void ImageViewerV2::onScrollTimelineFinished() {
 void ImageViewerV2::swapToOriginalPixmap() {
     if(!pixmap || !pixmapItemScaled.isVisible())
         return;
+    if(animation && originalStale) {
+        originalStale = false;
+        updatePixmap(std::unique_ptr<QPixmap>(new QPixmap(QPixmap::fromImage(currentFrameImage))));
+    }
     pixmapItemScaled.hide();
     pixmapItemScaled.setPixmap(QPixmap());
     pixmapScaled.reset(nullptr);
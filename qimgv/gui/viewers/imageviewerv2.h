@@ -7,13 +7,13 @@
 #include <QWheelEvent>
 #include <QTimeLine>
 #include <QScrollBar>
-#include <QMovie>
 #include <QColor>
 #include <QTimer>
 #include <QDebug>
 #include <memory>
 #include <cmath>
 #include "settings.h"
+#include "components/animation/animationprefetcher.h"
 
 enum MouseInteractionState {
     MOUSE_NONE,
@@ -41,7 +41,7 @@ public:
     virtual float currentScale() const;
     virtual QSize sourceSize() const;
     virtual void showImage(std::unique_ptr<QPixmap> _pixmap);
-    virtual void showAnimation(std::shared_ptr<QMovie> _animation);
+    virtual void showAnimation(std::shared_ptr<AnimationDecoder> _animation);
     virtual void setScaledPixmap(std::unique_ptr<QPixmap> newFrame);
     virtual bool isDisplaying() const;
 
@@ -68,6 +68,7 @@ signals:
     void animationPaused(bool);
     void frameChanged(int);
     void durationChanged(int);
+    void playbackError(QString);
 
 public slots:
     virtual void setFitMode(ImageFitMode mode);
@@ -116,6 +117,9 @@ protected:
 
 protected slots:
     void onAnimationTimer();
+    void onFrameReady();
+    void onFrameCountChanged(int count);
+    void onAnimationFailed();
 
 private slots:
     void requestScaling();
@@ -128,7 +132,18 @@ private:
     QGraphicsScene *scene;
     std::shared_ptr<QPixmap> pixmap;
     std::unique_ptr<QPixmap> pixmapScaled;
-    std::shared_ptr<QMovie> movie;
+    std::shared_ptr<AnimationDecoder> animation;
+    std::unique_ptr<AnimationPrefetcher> prefetcher;
+    int currentFrame, currentDelay;
+    // playing, but the next frame is not decoded yet
+    bool waitingForFrame;
+    // a seek to an uncached frame is in flight
+    bool seekPending;
+    QElapsedTimer animationClock;
+    qint64 frameDeadline;
+    // full size frame on screen; `pixmap` lags behind while a scaled frame is shown
+    QImage currentFrameImage;
+    bool originalStale;
     QGraphicsPixmapItem pixmapItem, pixmapItemScaled;
     QTimer *animationTimer, *scaleTimer;
     QScrollBar *hs, *vs;
@@ -186,6 +201,9 @@ private:
     void swapToOriginalPixmap();
     void setZoomAnchor(QPoint viewportPos);
     void updatePixmap(std::unique_ptr<QPixmap> newPixmap);
+    bool isLastFrame(int frame) const;
+    void setAnimationFrame(const AnimationFrame &frame);
+    void requestAnimationScaling();
     Qt::TransformationMode selectTransformationMode();
     void centerIfNecessary();
     void snapToEdges();
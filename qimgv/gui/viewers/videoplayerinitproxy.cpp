@@ -16,12 +16,7 @@ VideoPlayerInitProxy::VideoPlayerInitProxy(QWidget *parent)
     setLayout(&layout);
     connect(settings, &Settings::settingsChanged, this, &VideoPlayerInitProxy::onSettingsChanged);
     libFile = QIMGV_PLAYER_PLUGIN;
-#ifdef _WIN32
-    libDirs << QApplication::applicationDirPath() + "/plugins";
-#else
-    QDir libPath(QApplication::applicationDirPath() + "/../lib/qimgv");
-    libDirs << (libPath.makeAbsolute() ? libPath.path() : ".") << "/usr/lib/qimgv" << "/usr/lib64/qimgv";
-#endif
+    libDirs = settings->playerPluginDirs();
 }
 
 VideoPlayerInitProxy::~VideoPlayerInitProxy() {
@@ -35,6 +35,7 @@ ViewerWidget::ViewerWidget(QWidget *parent)
     connect(imageViewer.get(), &ImageViewerV2::scalingRequested, this, &ViewerWidget::scalingRequested);
     connect(imageViewer.get(), &ImageViewerV2::scaleChanged, this, &ViewerWidget::onScaleChanged);
     connect(imageViewer.get(), &ImageViewerV2::playbackFinished, this, &ViewerWidget::onAnimationPlaybackFinished);
+    connect(imageViewer.get(), &ImageViewerV2::playbackError, this, &ViewerWidget::playbackError);
     connect(this, &ViewerWidget::toggleTransparencyGrid, imageViewer.get(), &ImageViewerV2::toggleTransparencyGrid);
     connect(this, &ViewerWidget::setFilterNearest,       imageViewer.get(), &ImageViewerV2::setFilterNearest);
     connect(this, &ViewerWidget::setFilterBilinear,      imageViewer.get(), &ImageViewerV2::setFilterBilinear);
@@ -218,12 +219,12 @@ bool ViewerWidget::showImage(std::unique_ptr<QPixmap> pixmap) {
     return true;
 }
 
-bool ViewerWidget::showAnimation(std::shared_ptr<QMovie> movie) {
-    if(!movie)
+bool ViewerWidget::showAnimation(std::shared_ptr<AnimationDecoder> animation) {
+    if(!animation)
         return false;
     stopPlayback();
     enableImageViewer();
-    imageViewer->showAnimation(movie);
+    imageViewer->showAnimation(animation);
     hideCursorTimed(false);
     return true;
 }
@@ -28,7 +28,7 @@ public:
     bool interactionEnabled();
 
     bool showImage(std::unique_ptr<QPixmap> pixmap);
-    bool showAnimation(std::shared_ptr<QMovie> movie);
+    bool showAnimation(std::shared_ptr<AnimationDecoder> animation);
     void onScalingFinished(std::unique_ptr<QPixmap> scaled);
     bool isDisplaying();
     bool lockZoomEnabled();
@@ -88,6 +88,7 @@ signals:
     void setFilterBilinear();
     void setScalingFilter(ScalingFilter filter);
     void playbackFinished();
+    void playbackError(QString);
     void toggleLockZoom();
     void toggleLockView();
     void showScriptSettings();
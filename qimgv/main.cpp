@@ -10,6 +10,8 @@
 #include "utils/actions.h"
 #include "utils/cmdoptionsrunner.h"
 #include "sharedresources.h"
+#include "components/cache/metadataindex.h"
+#include "components/cache/thumbnailcache.h"
 #include "proxystyle.h"
 #include "core.h"
 
@@ -119,6 +121,8 @@ int main(int argc, char *argv[]) {
     scriptManager = ScriptManager::getInstance();
     actionManager = ActionManager::getInstance();
     shrRes = SharedResources::getInstance();
+    metadataIndex = MetadataIndex::getInstance();
+    thumbnailCache = ThumbnailCache::getInstance();
 
     atexit(saveSettings);
 
@@ -136,8 +140,8 @@ int main(int argc, char *argv[]) {
             QCoreApplication::translate("main", "Generate all thumbnails for directory."),
             QCoreApplication::translate("main", "directory-path")},
         {"gen-thumbs-size",
-            QCoreApplication::translate("main", "Thumbnail size. Current size is used if not specified."),
-            QCoreApplication::translate("main", "thumbnail-size")},
+            QCoreApplication::translate("main", "Thumbnail size, or a comma-separated list of sizes (e.g. 120,200,400). Current size is used if not specified."),
+            QCoreApplication::translate("main", "thumbnail-sizes")},
         {"build-options",
             QCoreApplication::translate("main", "Show build options.")},
     });
@@ -148,13 +152,17 @@ int main(int argc, char *argv[]) {
         QTimer::singleShot(0, &r, &CmdOptionsRunner::showBuildOptions);
         return a.exec();
     } else if(parser.isSet("gen-thumbs")) {
-        int size = settings->folderViewIconSize();
-        if(parser.isSet("gen-thumbs-size"))
-            size = parser.value("gen-thumbs-size").toInt();
+        QList<int> sizes;
+        if(parser.isSet("gen-thumbs-size")) {
+            for(auto &value : parser.value("gen-thumbs-size").split(",", Qt::SkipEmptyParts))
+                sizes << value.trimmed().toInt();
+        }
+        if(sizes.isEmpty())
+            sizes << settings->folderViewIconSize();
 
         CmdOptionsRunner r;
         QTimer::singleShot(0, &r,
-                           std::bind(&CmdOptionsRunner::generateThumbs, &r, parser.value("gen-thumbs"), size));
+                           std::bind(&CmdOptionsRunner::generateThumbs, &r, parser.value("gen-thumbs"), sizes));
         return a.exec();
     }
 
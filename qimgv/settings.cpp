@@ -308,6 +308,18 @@ void Settings::setMpvBinary(QString path) {
         settings->settingsConf->setValue("mpvBinary", path);
     }
 }
+
+// where to look for the video player plugin
+QStringList Settings::playerPluginDirs() {
+    QStringList dirs;
+#ifdef _WIN32
+    dirs << QCoreApplication::applicationDirPath() + "/plugins";
+#else
+    QDir libPath(QCoreApplication::applicationDirPath() + "/../lib/qimgv");
+    dirs << (libPath.makeAbsolute() ? libPath.path() : ".") << "/usr/lib/qimgv" << "/usr/lib64/qimgv";
+#endif
+    return dirs;
+}
 //------------------------------------------------------------------------------
 QList<QByteArray> Settings::supportedFormats() {
     auto formats = QImageReader::supportedImageFormats();
@@ -415,14 +427,14 @@ void Settings::setBlurBackground(bool mode) {
 }
 //------------------------------------------------------------------------------
 void Settings::setSortingMode(SortingMode mode) {
-    if(mode >= 6)
+    if(mode >= SORT_MODE_COUNT)
         mode = SortingMode::SORT_NAME_ASC;
     settings->settingsConf->setValue("sortingMode", mode);
 }
 
 SortingMode Settings::sortingMode() {
     int mode = settings->settingsConf->value("sortingMode", 0).toInt();
-    if(mode < 0 || mode >= 6)
+    if(mode < 0 || mode >= SORT_MODE_COUNT)
         mode = 0;
     return static_cast<SortingMode>(mode);
 }
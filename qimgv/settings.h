@@ -25,7 +25,15 @@ enum SortingMode {
     SORT_SIZE_ASC,
     SORT_SIZE_DESC,
     SORT_TIME_ASC,
-    SORT_TIME_DESC
+    SORT_TIME_DESC,
+    // from the metadata index
+    SORT_DATE_TAKEN_ASC,
+    SORT_DATE_TAKEN_DESC,
+    SORT_DIMENSIONS_ASC,
+    SORT_DIMENSIONS_DESC,
+    SORT_CAMERA_ASC,
+    SORT_CAMERA_DESC,
+    SORT_MODE_COUNT
 };
 
 enum ImageFitMode {
@@ -124,6 +132,7 @@ public:
     QString thumbnailCacheDir();
     QString mpvBinary();
     void setMpvBinary(QString path);
+    QStringList playerPluginDirs();
     PanelPosition panelPosition();
     void setPanelPosition(PanelPosition);
     bool loopSlideshow();
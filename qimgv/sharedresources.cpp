@@ -44,6 +44,36 @@ QPixmap *SharedResources::getPixmap(ShrIcon icon, qreal dpr) {
     return pixmap;
 }
 
+QImage SharedResources::folderIcon(int size, QColor color) {
+    QString key = QString::number(size) + ":" + QString::number(color.rgba());
+    QMutexLocker locker(&folderIconMutex);
+    auto it = folderIcons.constFind(key);
+    if(it != folderIcons.constEnd())
+        return it.value();
+    QSvgRenderer svgRenderer;
+    svgRenderer.load(QString(":/res/icons/common/other/folder32-scalable.svg"));
+    int factor = (size * 0.90f) / svgRenderer.defaultSize().width();
+    QImage icon(svgRenderer.defaultSize() * factor, QImage::Format_ARGB32_Premultiplied);
+    icon.fill(Qt::transparent);
+    QPainter painter(&icon);
+    svgRenderer.render(&painter);
+    painter.end();
+    ImageLib::recolor(icon, color);
+    folderIcons.insert(key, icon);
+    return icon;
+}
+
+std::shared_ptr<QPixmap> SharedResources::folderIconPixmap(int size, QColor color, qreal dpr) {
+    QString key = QString::number(size) + ":" + QString::number(color.rgba()) + ":" + QString::number(dpr);
+    auto it = folderIconPixmaps.constFind(key);
+    if(it != folderIconPixmaps.constEnd())
+        return it.value();
+    std::shared_ptr<QPixmap> pixmap(new QPixmap(QPixmap::fromImage(folderIcon(size, color))));
+    pixmap->setDevicePixelRatio(dpr);
+    folderIconPixmaps.insert(key, pixmap);
+    return pixmap;
+}
+
 SharedResources *SharedResources::getInstance() {
     if(!shrRes) {
         shrRes = new SharedResources();
@@ -1,7 +1,14 @@
 #pragma once
 
 #include <QPixmap>
+#include <QImage>
+#include <QHash>
+#include <QMutex>
+#include <QPainter>
+#include <QtSvg/QSvgRenderer>
 #include <QDebug>
+#include <memory>
+#include "utils/imagelib.h"
 
 enum ShrIcon {
     SHR_ICON_ERROR,
@@ -16,9 +23,16 @@ public:
     ~SharedResources();
 
     QPixmap *getPixmap(ShrIcon icon, qreal dpr);
+    // rendered once per (size, color); thread safe
+    QImage folderIcon(int size, QColor color);
+    // gui thread only
+    std::shared_ptr<QPixmap> folderIconPixmap(int size, QColor color, qreal dpr);
 private:
     QPixmap *mLoadingIcon72 = nullptr;
     QPixmap *mLoadingErrorIcon72 = nullptr;
+    QMutex folderIconMutex;
+    QHash<QString, QImage> folderIcons;
+    QHash<QString, std::shared_ptr<QPixmap>> folderIconPixmaps;
 };
 
 extern SharedResources *shrRes;
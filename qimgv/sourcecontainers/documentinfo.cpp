@@ -1,4 +1,5 @@
 #include "documentinfo.h"
+#include "components/cache/metadataindex.h"
 
 DocumentInfo::DocumentInfo(QString path)
     : mDocumentType(DocumentType::NONE),
@@ -197,6 +198,9 @@ void DocumentInfo::loadExifTags() {
 
         assert(image.get() != 0);
         image->readMetadata();
+        // the header is read anyway
+        if(metadataIndex)
+            metadataIndex->store(fileInfo.filePath(), MetadataIndex::fromExif(*image));
         Exiv2::ExifData &exifData = image->exifData();
         if(exifData.empty())
             return;
@@ -51,6 +51,10 @@ QDateTime Image::lastModified() const {
     return mDocInfo->lastModified();
 }
 
+void Image::loadExifTags() {
+	mDocInfo->loadExifTags();
+}
+
 QMap<QString, QString> Image::getExifTags() {
 	return mDocInfo->getExifTags();
 }
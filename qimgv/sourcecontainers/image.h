@@ -28,6 +28,8 @@ public:
     bool isEdited() const;
     qint64 fileSize() const;
     QDateTime lastModified() const;
+    // parses exif ahead of getExifTags(), e.g. on the loader thread
+    void loadExifTags();
     QMap<QString, QString> getExifTags();
 
 		QString format() const;
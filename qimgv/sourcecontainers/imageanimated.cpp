@@ -25,17 +25,15 @@ ImageAnimated::~ImageAnimated() {
 void ImageAnimated::load() {
     if(isLoaded())
         return;
-    loadMovie();
+    loadAnimation();
     mLoaded = true;
 }
 
-void ImageAnimated::loadMovie() {
-    movie.reset(new QMovie());
-    movie->setFileName(mPath);
-    movie->setFormat(mDocInfo->format().toStdString().c_str());
-    movie->jumpToFrame(0);
-    mSize = movie->frameRect().size();
-    mFrameCount = movie->frameCount();
+// decodes the first frame; runs on the loader thread
+void ImageAnimated::loadAnimation() {
+    animation.reset(new AnimationDecoder(mPath, mDocInfo->format().toLatin1()));
+    mSize = animation->size();
+    mFrameCount = animation->frameCount();
 }
 
 int ImageAnimated::frameCount() {
@@ -44,7 +42,7 @@ int ImageAnimated::frameCount() {
 
 void ImageAnimated::closeMovie()
 {
-	movie = nullptr;
+	animation = nullptr;
 }
 
 // TODO: overwrite (self included)
@@ -82,10 +80,10 @@ std::shared_ptr<const QImage> ImageAnimated::getImage() {
     return img;
 }
 
-std::shared_ptr<QMovie> ImageAnimated::getMovie() {
-    if(movie == nullptr)
-        loadMovie();
-    return movie;
+std::shared_ptr<AnimationDecoder> ImageAnimated::getAnimation() {
+    if(animation == nullptr)
+        loadAnimation();
+    return animation;
 }
 
 int ImageAnimated::height() {
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "image.h"
-#include <QMovie>
+#include "components/animation/animationdecoder.h"
 #include <QTimer>
 
 class ImageAnimated : public Image {
@@ -12,7 +12,7 @@ public:
 
     std::unique_ptr<QPixmap> getPixmap();
     std::shared_ptr<const QImage> getImage();
-    std::shared_ptr<QMovie> getMovie();
+    std::shared_ptr<AnimationDecoder> getAnimation();
     int height();
     int width();
     QSize size();
@@ -35,6 +35,6 @@ private:
     void load();
     QSize mSize;
     int mFrameCount;
-    std::shared_ptr<QMovie> movie;
-    void loadMovie();
+    std::shared_ptr<AnimationDecoder> animation;
+    void loadAnimation();
 };
@@ -10,6 +10,16 @@ Thumbnail::Thumbnail(QString _name, QString _info, int _size, std::shared_ptr<QP
         mHasAlphaChannel = _pixmap->hasAlphaChannel();
 }
 
+Thumbnail::Thumbnail(QString _name, QString _info, int _size, std::shared_ptr<QImage> _image)
+    : mName(_name),
+      mInfo(_info),
+      mImage(_image),
+      mSize(_size)
+{
+    if(_image)
+        mHasAlphaChannel = _image->hasAlphaChannel();
+}
+
 QString Thumbnail::name() {
     return mName;
 }
@@ -29,3 +39,11 @@ bool Thumbnail::hasAlphaChannel() {
 std::shared_ptr<QPixmap> Thumbnail::pixmap() {
     return mPixmap;
 }
+
+void Thumbnail::createPixmap(qreal dpr) {
+    if(!mImage)
+        return;
+    mPixmap.reset(new QPixmap(QPixmap::fromImage(*mImage)));
+    mPixmap->setDevicePixelRatio(dpr);
+    mImage.reset();
+}
@@ -2,19 +2,26 @@
 
 #include <QString>
 #include <QPixmap>
+#include <QImage>
 #include <memory>
 
+// Thumbnails are produced on worker threads as QImage.
+// The pixmap has to be created on the GUI thread via createPixmap()
 class Thumbnail {
 public:
     Thumbnail(QString _name, QString _info, int _size, std::shared_ptr<QPixmap> _pixmap);
+    Thumbnail(QString _name, QString _info, int _size, std::shared_ptr<QImage> _image);
     QString name();
     QString info();
     int size();
     bool hasAlphaChannel();
     std::shared_ptr<QPixmap> pixmap();
+    // GUI thread only. Converts the pending image and drops it
+    void createPixmap(qreal dpr);
 private:
     QString mName, mInfo;
     std::shared_ptr<QPixmap> mPixmap;
+    std::shared_ptr<QImage> mImage;
     int mSize;
-    bool mHasAlphaChannel;
+    bool mHasAlphaChannel = false;
 };
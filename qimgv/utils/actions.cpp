@@ -90,6 +90,9 @@ void Actions::init() {
     mActions.insert("print", QVersionNumber(1,0,0));
     mActions.insert("toggleFullscreenInfoBar", QVersionNumber(1,0,0));
     mActions.insert("pasteFile", QVersionNumber(1,0,3));
+    mActions.insert("sortByDateTaken", QVersionNumber(1,1,0));
+    mActions.insert("sortByDimensions", QVersionNumber(1,1,0));
+    mActions.insert("filterFolderView", QVersionNumber(1,1,0));
 
 		mActions.insert("moveFilePath1", QVersionNumber(1,1,0));
 		mActions.insert("moveFilePath2", QVersionNumber(1,1,0));
@@ -1,15 +1,22 @@
 #include "cmdoptionsrunner.h"
 
-void CmdOptionsRunner::generateThumbs(QString dirPath, int size) {
-    if(size <= 50 || size > 400) {
-        qDebug() << "Error: Invalid thumbnail size.";
-        qDebug() << "Please specify a value between [50, 400].";
-        qDebug() << "Example:  qimgv --gen-thumbs=/home/user/Pictures/ --gen-thumbs-size=120";
-        QCoreApplication::exit(1);
-        return;
+#include <csignal>
+
+static void onInterruptSignal(int) {
+    ThumbnailWarmer::interrupt();
+}
+
+void CmdOptionsRunner::generateThumbs(QString dirPath, QList<int> sizes) {
+    for(auto size : sizes) {
+        if(size <= 50 || size > 400) {
+            qDebug() << "Error: Invalid thumbnail size.";
+            qDebug() << "Please specify a value between [50, 400].";
+            qDebug() << "Example:  qimgv --gen-thumbs=/home/user/Pictures/ --gen-thumbs-size=120,200";
+            QCoreApplication::exit(1);
+            return;
+        }
     }
 
-    Thumbnailer th;
     DirectoryManager dm;
     if(!dm.setDirectory(dirPath, true, false)) {
         qDebug() << "Error: Invalid path.";
@@ -17,20 +24,31 @@ void CmdOptionsRunner::generateThumbs(QString dirPath, int size) {
         return;
     }
 
-    const QFileInfoList &files = dm.files();
+    QStringList paths;
+    for(unsigned long i = 0; i < dm.fileCount(); i++)
+        paths << dm.filePathAt(i);
+
+    QStringList sizeList;
+    for(auto size : sizes)
+        sizeList << QString::number(size);
 
     qDebug() << "\nDirectory:" << dirPath;
-    qDebug() << "File count:" << files.size();
-    qDebug() << "Size limit:" << size << "x" << size << "px";
-    qDebug() << "Generating thumbnails...";
+    qDebug() << "File count:" << paths.size();
+    qDebug() << "Sizes:" << sizeList.join(", ") << "px";
+    qDebug() << "Generating thumbnails... (Ctrl+C to stop)";
 
-    for (const QFileInfo &file : files) {
-	    th.getThumbnailAsync(file.absoluteFilePath(), size, false, false);
-		}
+    // finish files in progress and report instead of dying mid-write
+    std::signal(SIGINT, onInterruptSignal);
+    std::signal(SIGTERM, onInterruptSignal);
 
-    th.waitForDone();
-    qDebug() << "\nDone.";
-    QCoreApplication::quit();
+    ThumbnailWarmer warmer(paths, sizes, settings->squareThumbnails());
+    bool finished = warmer.run();
+
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    if(finished)
+        qDebug() << "\nDone.";
+    QCoreApplication::exit(finished ? 0 : 130);
 }
 
 void CmdOptionsRunner::showBuildOptions() {
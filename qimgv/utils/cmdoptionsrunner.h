@@ -5,10 +5,11 @@
 #include <QDebug>
 #include <QString>
 #include "core.h"
+#include "components/thumbnailer/thumbnailwarmer.h"
 
 class CmdOptionsRunner : public QObject {
     Q_OBJECT
 public slots:
-    void generateThumbs(QString dirPath, int size);
+    void generateThumbs(QString dirPath, QList<int> sizes);
     void showBuildOptions();
 };
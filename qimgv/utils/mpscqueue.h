@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QList>
+#include <atomic>
+
+// Lock-free multi-producer / single-consumer queue.
+// Producers push from any thread; one consumer takes everything at once.
+template<typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head(nullptr) {}
+    ~MpscQueue() { takeAll(); }
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // returns true if the queue was empty, i.e. the consumer needs a wakeup
+    bool push(T value) {
+        Node *node = new Node{ std::move(value), head.load(std::memory_order_relaxed) };
+        while(!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed));
+        return node->next == nullptr;
+    }
+
+    // consumer only. Items are returned in push order
+    QList<T> takeAll() {
+        Node *node = head.exchange(nullptr, std::memory_order_acquire);
+        QList<T> items;
+        while(node) {
+            items.prepend(std::move(node->value));
+            Node *next = node->next;
+            delete node;
+            node = next;
+        }
+        return items;
+    }
+
+private:
+    struct Node {
+        T value;
+        Node *next;
+    };
+    std::atomic<Node*> head;
+};
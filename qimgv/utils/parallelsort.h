@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QThreadPool>
+#include <QThread>
+#include <algorithm>
+#include <vector>
+
+// Sorts [first, last) on several threads. Chunks are sorted in parallel,
+// then merged pairwise (also in parallel). Small ranges use plain std::sort.
+// The comparator must be safe to call concurrently.
+template<typename RandomIt, typename Compare>
+void parallelSort(RandomIt first, RandomIt last, Compare comp, int minChunkSize = 8192) {
+    auto count = last - first;
+    int chunks = std::min<int>(QThread::idealThreadCount(), static_cast<int>(count / minChunkSize));
+    if(chunks < 2) {
+        std::sort(first, last, comp);
+        return;
+    }
+    std::vector<RandomIt> bounds;
+    for(int i = 0; i <= chunks; i++)
+        bounds.push_back(first + count * i / chunks);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(chunks);
+    for(int i = 0; i < chunks; i++) {
+        RandomIt begin = bounds[i], end = bounds[i + 1];
+        pool.start([begin, end, &comp]() { std::sort(begin, end, comp); });
+    }
+    pool.waitForDone();
+    for(int width = 1; width < chunks; width *= 2) {
+        for(int i = 0; i + width < chunks; i += 2 * width) {
+            RandomIt begin = bounds[i], middle = bounds[i + width], end = bounds[std::min(i + 2 * width, chunks)];
+            pool.start([begin, middle, end, &comp]() { std::inplace_merge(begin, middle, end, comp); });
+        }
+        pool.waitForDone();
+    }
+}
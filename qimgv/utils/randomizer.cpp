@@ -1,49 +1,46 @@
 #include "randomizer.h"
 
-Randomizer::Randomizer() {
-    setCount(0);
+Randomizer::Randomizer() : Randomizer(0) {
 }
 
-Randomizer::Randomizer(int _count) : currentIndex(0) {
+Randomizer::Randomizer(int _count)
+    : currentIndex(0),
+      rng(std::chrono::steady_clock::now().time_since_epoch().count())
+{
     setCount(_count);
 }
 
 void Randomizer::setCount(int _count) {
     vec.resize(_count);
     fill();
+    currentIndex = 0;
+}
+
+int Randomizer::count() const {
+    return static_cast<int>(vec.size());
 }
 
 void Randomizer::shuffle() {
-    std::mt19937 rng(std::chrono::steady_clock::now().time_since_epoch().count());
     std::shuffle(vec.begin(), vec.end(), rng);
+    for(int i = 0; i < count(); i++)
+        pos[vec[i]] = i;
 }
 
 void Randomizer::setCurrent(int _current) {
     currentIndex = indexOf(_current);
 }
 
-// this assumes our array contains shuffled int values [0 ... count]
-// which it does in our case
-int Randomizer::indexOf(int item) {
-    int index = -1;
-    if(item >= vec.size())
-        return index;
-    std::vector<int>::iterator it;
-    int i = 0;
-    for (it = vec.begin(); it != vec.end(); ++it, ++i) {
-        if(vec[i] == item) {
-            index = i;
-            break;
-        }
-    }
-    return index;
+int Randomizer::indexOf(int item) const {
+    if(item < 0 || item >= count())
+        return -1;
+    return pos[item];
 }
 
 void Randomizer::fill() {
-    std::vector<int>::iterator it;
-    int i = 0;
-    for (it = vec.begin(); it != vec.end(); ++it, ++i) {
-        *it = i;
+    pos.resize(vec.size());
+    for(int i = 0; i < count(); i++) {
+        vec[i] = i;
+        pos[i] = i;
     }
 }
 
@@ -56,24 +53,142 @@ void Randomizer::print() {
     qDebug() << "----end----";
 }
 
-int Randomizer::next() {
-    // re-shuffle when needed
-    // because vector gets rearranged this will break prev()
-    while(currentIndex == vec.size() - 1) {
-        int currentItem = vec[currentIndex];
-        shuffle();
-        setCurrent(currentItem);
+void Randomizer::place(int item, int index) {
+    int from = pos[item];
+    std::swap(vec[from], vec[index]);
+    pos[vec[from]] = from;
+    pos[item] = index;
+}
+
+// Starts a new round once the current one runs out (needs 3+ items).
+// The current item and the one we came from go to the edge we are moving
+// away from: the current one can't come up again right away, and stepping
+// back still works
+void Randomizer::reshuffle(bool forward) {
+    int currentItem = vec[currentIndex];
+    int lastItem = vec[forward ? currentIndex - 1 : currentIndex + 1];
+    shuffle();
+    if(forward) {
+        place(lastItem, 0);
+        place(currentItem, 1);
+    } else {
+        place(lastItem, count() - 1);
+        place(currentItem, count() - 2);
     }
-    currentIndex++;
-    return vec[currentIndex];
+    currentIndex = pos[currentItem];
+}
+
+int Randomizer::peekNext() {
+    if(vec.empty())
+        return -1;
+    if(currentIndex == -1)
+        return vec.front();
+    if(count() <= 2)
+        return vec[(currentIndex + 1) % count()];
+    if(currentIndex == count() - 1)
+        reshuffle(true);
+    return vec[currentIndex + 1];
+}
+
+int Randomizer::peekPrev() {
+    if(vec.empty())
+        return -1;
+    if(currentIndex == -1)
+        return vec.back();
+    if(count() <= 2)
+        return vec[(currentIndex + count() - 1) % count()];
+    if(currentIndex == 0)
+        reshuffle(false);
+    return vec[currentIndex - 1];
+}
+
+int Randomizer::next() {
+    int item = peekNext();
+    if(item != -1)
+        currentIndex = pos[item];
+    return item;
 }
 
 int Randomizer::prev() {
-    while(currentIndex == 0) {
-        int currentItem = vec[currentIndex];
-        shuffle();
-        setCurrent(currentItem);
+    int item = peekPrev();
+    if(item != -1)
+        currentIndex = pos[item];
+    return item;
+}
+
+// The new item lands somewhere in the part of the round not yet shown
+void Randomizer::insert(int item) {
+    if(item < 0 || item > count())
+        return;
+    for(auto &i : vec) {
+        if(i >= item)
+            i++;
+    }
+    pos.insert(pos.begin() + item, 0);
+    std::uniform_int_distribution<int> dist(qMin(currentIndex + 1, count()), count());
+    int at = dist(rng);
+    vec.push_back(item);
+    std::swap(vec[at], vec.back());
+    for(int i = at; i < count(); i++)
+        pos[vec[i]] = i;
+}
+
+// Same as insert() for each item, in one pass over the order
+void Randomizer::insert(const QList<int> &items) {
+    int newCount = count() + items.count();
+    // old item -> new item: the positions not taken by the inserted ones
+    std::vector<int> shifted;
+    shifted.reserve(count());
+    for(int i = 0, next = 0; i < newCount; i++) {
+        if(next < items.count() && items[next] == i)
+            next++;
+        else
+            shifted.push_back(i);
+    }
+    if(static_cast<int>(shifted.size()) != count())
+        return;
+    for(auto &i : vec)
+        i = shifted[i];
+    int first = qMin(currentIndex + 1, count());
+    for(int item : items) {
+        std::uniform_int_distribution<int> dist(first, count());
+        int at = dist(rng);
+        vec.push_back(item);
+        std::swap(vec[at], vec.back());
+    }
+    pos.resize(vec.size());
+    for(int i = 0; i < count(); i++)
+        pos[vec[i]] = i;
+}
+
+void Randomizer::remove(int item) {
+    int index = indexOf(item);
+    if(index == -1)
+        return;
+    vec.erase(vec.begin() + index);
+    pos.erase(pos.begin() + item);
+    for(int i = 0; i < count(); i++) {
+        if(vec[i] > item)
+            vec[i]--;
+        pos[vec[i]] = i;
+    }
+    // step back so next() picks up where the removed item was
+    if(index <= currentIndex)
+        currentIndex = qMax(currentIndex - 1, 0);
+}
+
+// renamed file changing its place in the list; keeps its place in the order
+void Randomizer::move(int from, int to) {
+    int index = indexOf(from);
+    if(index == -1 || to < 0 || to >= count() || from == to)
+        return;
+    for(auto &i : vec) {
+        if(from < to && i > from && i <= to)
+            i--;
+        else if(from > to && i >= to && i < from)
+            i++;
     }
-    currentIndex--;
-    return vec[currentIndex];
+    vec[index] = to;
+    for(int i = 0; i < count(); i++)
+        pos[vec[i]] = i;
 }
@@ -7,23 +7,44 @@
 #include <vector>
 
 #include <QDebug>
+#include <QList>
 #include <QString>
 
+// Shuffled playback order over [0 ... count).
+// Keeps the inverse permutation so locating an item is O(1).
 class Randomizer {
 public:
     Randomizer();
     Randomizer(int _count);
 
     void setCount(int _count);
+    int count() const;
     int next();
     int prev();
+    // what next() / prev() would return. Doesn't move, but at the end
+    // of a round this already starts the new one that next() / prev() continue
+    int peekNext();
+    int peekPrev();
 
     void shuffle();
     void print();
     void setCurrent(int _current);
+
+    // keep the order when the list changes by one item.
+    // items are list indexes, so the ones after `item` shift by one
+    void insert(int item);
+    // ascending indexes in the new list, e.g. a merged scan batch
+    void insert(const QList<int> &items);
+    void remove(int item);
+    void move(int from, int to);
 private:
     int currentIndex;
     std::vector<int> vec;
+    // item -> position in vec
+    std::vector<int> pos;
+    std::mt19937 rng;
     void fill();
-    int indexOf(int n);
+    int indexOf(int item) const;
+    void place(int item, int index);
+    void reshuffle(bool forward);
 };